@@ -0,0 +1,604 @@
+#include <new>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <cstdlib>
+#include <iostream>
+
+#include "test/common.hpp"
+#include "zombie/zombie.hpp"
+
+// Micro benchmarks for the runtime.
+// `bench` run all of them, `bench <name>` run a single one.
+
+// every allocation of the process is counted, see AllocationsPerBind.
+std::atomic<size_t> allocation_count = 0;
+
+void* operator new(size_t size) {
+  ++allocation_count;
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+  ++allocation_count;
+  size_t a = static_cast<size_t>(align);
+  if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+template<typename F>
+double measure_seconds(const F& f) {
+  auto begin = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+constexpr ZombieConfig shared_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_runtime(RuntimeMode::Shared);
+
+namespace Shared {
+  IMPORT_ZOMBIE(shared_cfg)
+}
+
+// every thread read random values from one shared graph.
+// one read in [miss_every] evict the value first, forcing a serialized recompute.
+void SharedScaling() {
+  using namespace Shared;
+  constexpr size_t graph_size = 1024;
+  constexpr size_t reads_per_thread = 1 << 18;
+  constexpr size_t miss_every = 4096;
+
+  std::vector<Zombie<int>> zs;
+  zs.push_back(Zombie<int>(0));
+  for (size_t i = 1; i < graph_size; ++i) {
+    zs.push_back(bindZombie([](int x) { return Zombie<int>(x + 1); }, zs.back()));
+  }
+
+  for (size_t thread_count = 1; thread_count <= 32; thread_count *= 2) {
+    double seconds = measure_seconds([&]() {
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&, i]() {
+          std::default_random_engine re(i);
+          std::uniform_int_distribution<size_t> dist(0, graph_size - 1);
+          int64_t sum = 0;
+          for (size_t j = 0; j < reads_per_thread; ++j) {
+            size_t idx = dist(re);
+            if (j % miss_every == 0) {
+              zs[idx].evict();
+            }
+            sum += zs[idx].get_value();
+          }
+          assert(sum > 0);
+        });
+      }
+      for (std::thread& th : threads) {
+        th.join();
+      }
+    });
+    double mops = thread_count * reads_per_thread / seconds / 1e6;
+    std::cout << "shared_scaling threads: " << thread_count
+              << ", seconds: " << seconds
+              << ", Mreads/s: " << mops << std::endl;
+  }
+}
+
+// the akasha operations of a long run, on [context_count] contexts:
+// append in tock order, predecessor lookups (random and sequential), evicting half, then lookups again.
+template<typename Index>
+void AkashaOps(const std::string& name) {
+  constexpr int64_t context_count = 10'000'000;
+  // a context span a few tocks.
+  constexpr int64_t stride = 3;
+  using Value = std::shared_ptr<int>;
+
+  Index index;
+  std::default_random_engine re(0);
+  std::uniform_int_distribution<int64_t> dist(0, context_count * stride - 1);
+  int64_t found = 0;
+  auto report = [&](const std::string& phase, double seconds) {
+    std::cout << "akasha " << name << " " << phase << ": " << seconds << "s, "
+              << context_count / seconds / 1e6 << " Mops/s" << std::endl;
+  };
+  report("append", measure_seconds([&]() {
+    for (int64_t i = 0; i < context_count; ++i) {
+      index.insert(Tock(i * stride), Value());
+    }
+  }));
+  report("find_le random", measure_seconds([&]() {
+    for (int64_t i = 0; i < context_count; ++i) {
+      found += index.find_le_node(Tock(dist(re)))->k.tock;
+    }
+  }));
+  report("find_le sequential", measure_seconds([&]() {
+    for (int64_t i = 0; i < context_count; ++i) {
+      found += index.find_le_node(Tock(i * stride + 1))->k.tock;
+    }
+  }));
+  report("evict half", measure_seconds([&]() {
+    for (int64_t i = 1; i < context_count; i += 2) {
+      auto* n = index.find_precise_node(Tock(i * stride));
+      // eviction look at the neighbour before removing.
+      found += n->prev()->k.tock;
+      index.remove(n);
+    }
+  }));
+  report("find_le random after evict", measure_seconds([&]() {
+    for (int64_t i = 0; i < context_count; ++i) {
+      found += index.find_le_node(Tock(dist(re)))->k.tock;
+    }
+  }));
+  std::cout << "akasha " << name << " memory: " << index.memory_bytes() / (1 << 20) << "MiB" << std::endl;
+  assert(found > 0);
+}
+
+constexpr ZombieConfig unpooled_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_pool_allocation(false);
+constexpr ZombieConfig pooled_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_pool_allocation(true);
+
+// allocations (of any kind, by anyone) per bindZombie in a long chain.
+template<const ZombieConfig& cfg>
+void AllocationsPerBindOf(const std::string& name) {
+  using Z = ZombieInternal::ExternalZombie<cfg, int>;
+  constexpr size_t bind_count = 100'000;
+  std::vector<Z> zs;
+  zs.reserve(bind_count + 1);
+  zs.push_back(Z(0));
+  size_t before = allocation_count;
+  double seconds = measure_seconds([&]() {
+    for (size_t i = 0; i < bind_count; ++i) {
+      zs.push_back(ZombieInternal::bindZombie<cfg>([](int x) { return Z(x + 1); }, zs.back().z));
+    }
+  });
+  std::cout << "allocations_per_bind " << name << ": "
+            << static_cast<double>(allocation_count - before) / bind_count
+            << ", seconds: " << seconds << std::endl;
+}
+
+void AllocationsPerBind() {
+  AllocationsPerBindOf<unpooled_cfg>("unpooled");
+  AllocationsPerBindOf<pooled_cfg>("pooled");
+}
+
+constexpr ZombieConfig murder_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1});
+constexpr ZombieConfig reclaim_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1});
+
+// evicting every context of a long chain: one murder() at a time, or a single evict_while().
+// both pick the same victims in the same order, evict_while() only take the lock once.
+template<const ZombieConfig& cfg>
+void ReclaimOf(const std::string& name, bool single_lock) {
+  using Z = ZombieInternal::ExternalZombie<cfg, int>;
+  using Trailokya = ZombieInternal::Trailokya<cfg>;
+  constexpr size_t bind_count = 100'000;
+  std::vector<Z> zs;
+  zs.reserve(bind_count + 1);
+  zs.push_back(Z(0));
+  for (size_t i = 0; i < bind_count; ++i) {
+    zs.push_back(ZombieInternal::bindZombie<cfg>([](int x) { return Z(x + 1); }, zs.back().z));
+  }
+  auto& t = Trailokya::get_trailokya();
+  size_t before = t.resident_bytes;
+  double seconds = measure_seconds([&]() {
+    if (single_lock) {
+      t.reaper.evict_while([]() { return true; });
+    } else {
+      while (!t.reaper.have_soul()) {
+        t.reaper.murder();
+      }
+    }
+  });
+  std::cout << "reclaim " << name << ": " << seconds << "s, "
+            << bind_count / seconds / 1e6 << " M evictions/s, freed " << before - t.resident_bytes << " bytes" << std::endl;
+}
+
+void Reclaim() {
+  ReclaimOf<murder_cfg>("murder loop", false);
+  ReclaimOf<reclaim_cfg>("evict_while", true);
+}
+
+constexpr ZombieConfig fan_in_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1});
+
+// eviction throughput when every context read many earlier values, so cost() has many UF to look at.
+void EvictionFanIn() {
+  using Z = ZombieInternal::ExternalZombie<fan_in_cfg, int>;
+  using Trailokya = ZombieInternal::Trailokya<fan_in_cfg>;
+  constexpr size_t bind_count = 1'000;
+  std::vector<Z> zs;
+  zs.reserve(bind_count);
+  for (size_t i = 0; i < 6; ++i) {
+    zs.push_back(Z(i));
+  }
+  auto f = [](int a, int b, int c, int d, int e, int f) { return Z(a + b - c + d - e + f); };
+  for (size_t i = zs.size(); i < bind_count; ++i) {
+    zs.push_back(ZombieInternal::bindZombie<fan_in_cfg>(f, zs[i - 1].z, zs[i - 2].z, zs[i - 5].z,
+                                                        zs[i / 2].z, zs[i / 3].z, zs[i / 5].z));
+  }
+  auto& t = Trailokya::get_trailokya();
+  ZombieStats before = t.stats();
+  size_t evictions = 0;
+  size_t allocations_before = allocation_count;
+  double seconds = measure_seconds([&]() {
+    while (!t.reaper.have_soul()) {
+      t.reaper.murder();
+      ++evictions;
+    }
+  });
+  size_t allocations = allocation_count - allocations_before;
+  ZombieStats after = t.stats();
+  std::cout << "eviction_fan_in: " << seconds << "s, " << evictions / seconds / 1e3 << " K evictions/s, "
+            << double(allocations) / evictions << " allocations per eviction, "
+            << after.cost_evaluations - before.cost_evaluations << " cost evaluations, "
+            << after.cost_memo_hits - before.cost_memo_hits << " memo hits, "
+            << after.adjust_pop_repushes - before.adjust_pop_repushes << " repushes" << std::endl;
+}
+
+constexpr ZombieConfig approx_1_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1});
+constexpr ZombieConfig approx_1_1_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{11, 10});
+constexpr ZombieConfig approx_1_5_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{3, 2});
+constexpr ZombieConfig approx_2_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{2, 1});
+constexpr ZombieConfig approx_4_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{4, 1});
+
+// the forward/backward chain of debug.cpp, [memory_limit] resources alive at most:
+// how long evicting take against how much recomputation the looser order cost.
+template<const ZombieConfig& cfg>
+void ForwardBackwardChainOf(const std::string& name) {
+  struct Test {};
+  using Resource = Resource<Test>;
+  using Z = ZombieInternal::ExternalZombie<cfg, Resource>;
+  using Trailokya = ZombieInternal::Trailokya<cfg>;
+  constexpr int total_size = 2000;
+  constexpr size_t memory_limit = 40;
+  auto& t = Trailokya::get_trailokya();
+  double evict_seconds = 0;
+  size_t evictions = 0;
+  auto allocate_memory = [&]() {
+    evict_seconds += measure_seconds([&]() {
+      while (Resource::count >= memory_limit) {
+        t.reaper.murder();
+        ++evictions;
+      }
+    });
+  };
+  size_t work_done = 0;
+  std::vector<Z> zs;
+  double seconds = measure_seconds([&]() {
+    zs.push_back(ZombieInternal::bindZombie<cfg>([&]() {
+      allocate_memory();
+      t.meter.fast_forward(1ms);
+      ++work_done;
+      return Z(0);
+    }));
+    for (int i = 1; i < total_size; ++i) {
+      zs.push_back(ZombieInternal::bindZombie<cfg>([&](const Resource& x) {
+        allocate_memory();
+        t.meter.fast_forward(1ms);
+        ++work_done;
+        return Z(x.value + 1);
+      }, zs[i - 1].z));
+    }
+    for (int i = total_size - 1; i >= 0; --i) {
+      t.meter.fast_forward(1ms);
+      if (zs[i].shared_ptr()->get_ref().value != i) {
+        std::abort();
+      }
+    }
+  });
+  ZombieStats s = t.stats();
+  std::cout << name << ": " << seconds << "s, "
+            << evict_seconds / evictions * 1e6 << "us per eviction, "
+            << static_cast<double>(work_done) / total_size << "x recompute, "
+            << s.adjust_pop_repushes << " repushes, "
+            << s.adjust_pop_repushes_avoided << " avoided" << std::endl;
+}
+
+void ApproxFactor() {
+  ForwardBackwardChainOf<approx_1_cfg>("approx_factor 1");
+  ForwardBackwardChainOf<approx_1_1_cfg>("approx_factor 1.1");
+  ForwardBackwardChainOf<approx_1_5_cfg>("approx_factor 1.5");
+  ForwardBackwardChainOf<approx_2_cfg>("approx_factor 2");
+  ForwardBackwardChainOf<approx_4_cfg>("approx_factor 4");
+}
+
+constexpr ZombieConfig cost_policy_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::Cost);
+constexpr ZombieConfig gd_policy_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::GreedyDual);
+constexpr ZombieConfig gdsf_policy_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::GDSF);
+constexpr ZombieConfig lru_policy_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::LRU);
+constexpr ZombieConfig lfu_policy_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::LFU);
+
+void EvictionPolicies() {
+  ForwardBackwardChainOf<cost_policy_cfg>("eviction_policy cost");
+  ForwardBackwardChainOf<gd_policy_cfg>("eviction_policy greedy_dual");
+  ForwardBackwardChainOf<gdsf_policy_cfg>("eviction_policy gdsf");
+  ForwardBackwardChainOf<lru_policy_cfg>("eviction_policy lru");
+  ForwardBackwardChainOf<lfu_policy_cfg>("eviction_policy lfu");
+}
+
+constexpr ZombieConfig sampled_5_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_sampled_book(5);
+constexpr ZombieConfig sampled_16_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_sampled_book(16);
+constexpr ZombieConfig sampled_lru_cfg = lru_policy_cfg.with_sampled_book(5);
+
+// reading resident values at random, each read touching the book.
+template<const ZombieConfig& cfg>
+void BookHitsOf(const std::string& name) {
+  using Z = ZombieInternal::ExternalZombie<cfg, int>;
+  constexpr size_t bind_count = 100'000;
+  constexpr size_t read_count = 10'000'000;
+  std::vector<Z> zs = {Z(0)};
+  zs.reserve(bind_count + 1);
+  for (size_t i = 0; i < bind_count; ++i) {
+    zs.push_back(ZombieInternal::bindZombie<cfg>([](int x) { return Z(x + 1); }, zs.back().z));
+  }
+  std::default_random_engine re(0);
+  std::uniform_int_distribution<size_t> dist(1, bind_count);
+  int64_t sum = 0;
+  double seconds = measure_seconds([&]() {
+    for (size_t i = 0; i < read_count; ++i) {
+      sum += zs[dist(re)].get_value();
+    }
+  });
+  std::cout << "book_hits " << name << ": " << seconds / read_count * 1e9 << "ns per hit" << std::endl;
+  assert(sum > 0);
+}
+
+void SampledBookBench() {
+  ForwardBackwardChainOf<cost_policy_cfg>("sampled_book heap cost");
+  ForwardBackwardChainOf<sampled_5_cfg>("sampled_book sample 5 cost");
+  ForwardBackwardChainOf<sampled_16_cfg>("sampled_book sample 16 cost");
+  ForwardBackwardChainOf<lru_policy_cfg>("sampled_book heap lru");
+  ForwardBackwardChainOf<sampled_lru_cfg>("sampled_book sample 5 lru");
+  BookHitsOf<cost_policy_cfg>("heap");
+  BookHitsOf<sampled_5_cfg>("sample 5");
+}
+
+// reading the same resident value over and over.
+template<const ZombieConfig& cfg>
+void RepeatedHitsOf(const std::string& name) {
+  using Z = ZombieInternal::ExternalZombie<cfg, int>;
+  constexpr size_t read_count = 10'000'000;
+  Z root(0);
+  Z z = ZombieInternal::bindZombie<cfg>([](int x) { return Z(x + 1); }, root.z);
+  int64_t sum = 0;
+  double seconds = measure_seconds([&]() {
+    for (size_t i = 0; i < read_count; ++i) {
+      sum += z.get_value();
+    }
+  });
+  std::cout << "repeated_hits " << name << ": " << seconds / read_count * 1e9 << "ns per hit" << std::endl;
+  assert(sum > 0);
+}
+
+void AccessRecording() {
+  RepeatedHitsOf<gd_policy_cfg>("greedy_dual");
+  RepeatedHitsOf<lru_policy_cfg>("lru");
+  BookHitsOf<gd_policy_cfg>("greedy_dual");
+  BookHitsOf<lru_policy_cfg>("lru");
+}
+
+struct BookEntry {
+  int64_t key;
+  uint64_t id;
+  bool operator<(const BookEntry& r) const { return key < r.key; }
+};
+
+// like the book, every entry record where it is.
+struct BookEntryMoved {
+  std::vector<uint32_t>* index;
+  void operator()(const BookEntry& e, size_t idx) {
+    (*index)[e.id] = idx;
+  }
+};
+
+struct BookEntryRemoved {
+  void operator()(const BookEntry&) { }
+};
+
+// the book of a long run, on [entry_count] entries:
+// fill, then hold (pop the cheapest, push it back costlier, as eviction and recompute do), then drain.
+template<template<typename...> typename Heap>
+void BookHeapOps(const std::string& name, size_t entry_count) {
+  std::vector<uint32_t> index(entry_count);
+  Heap<BookEntry, std::less<BookEntry>, BookEntryMoved, BookEntryRemoved> heap(
+    std::less<BookEntry>(), BookEntryMoved{&index}, BookEntryRemoved());
+  std::default_random_engine re(0);
+  std::uniform_int_distribution<int64_t> dist(0, 1 << 30);
+  int64_t found = 0;
+  auto report = [&](const std::string& phase, double seconds) {
+    std::cout << "book_heap " << name << " " << entry_count << " " << phase << ": " << seconds << "s, "
+              << entry_count / seconds / 1e6 << " Mops/s" << std::endl;
+  };
+  report("push", measure_seconds([&]() {
+    for (size_t i = 0; i < entry_count; ++i) {
+      heap.push(BookEntry{dist(re), i});
+    }
+  }));
+  report("hold", measure_seconds([&]() {
+    for (size_t i = 0; i < entry_count; ++i) {
+      BookEntry e = heap.pop();
+      found += index[e.id];
+      e.key += dist(re);
+      heap.push(e);
+    }
+  }));
+  report("pop", measure_seconds([&]() {
+    while (!heap.empty()) {
+      found += heap.pop().key;
+    }
+  }));
+  assert(found > 0);
+}
+
+// sizes (for book_heap and book) from the command line after the bench name, default 10^6, 10^7 and 10^8.
+std::vector<size_t> book_heap_sizes = {1'000'000, 10'000'000, 100'000'000};
+
+template<typename T, typename Compare, typename NHIC, typename NHER>
+using PagedHeap = BHeap<T, Compare, NHIC, NHER>;
+
+void BookHeapBench() {
+  for (size_t n : book_heap_sizes) {
+    BookHeapOps<MinHeap>("binary", n);
+    BookHeapOps<PagedHeap>("paged", n);
+  }
+}
+
+constexpr ZombieConfig binary_book_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_book_heap(BookHeap::Binary);
+constexpr ZombieConfig paged_book_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_book_heap(BookHeap::Paged);
+constexpr ZombieConfig dary4_book_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_book_heap(BookHeap::DAry, 4);
+constexpr ZombieConfig dary8_book_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_book_heap(BookHeap::DAry, 8);
+
+struct BookIdMoved {
+  std::vector<uint32_t>* index;
+  void operator()(const uint32_t& id, size_t idx) {
+    (*index)[id] = idx;
+  }
+};
+
+struct BookIdRemoved {
+  void operator()(const uint32_t&) { }
+};
+
+// GDHeap itself, as Trailokya::book use it, on [entry_count] entries:
+// touch (an access to a resident value) and adjust_pop (an eviction), with int128 costs.
+template<const ZombieConfig& cfg>
+void BookOps(const std::string& name, size_t entry_count) {
+  std::vector<uint32_t> index(entry_count);
+  std::vector<cost_t> costs(entry_count);
+  GDHeap<cfg, uint32_t, BookIdMoved, BookIdRemoved> book(BookIdMoved{&index}, BookIdRemoved());
+  std::default_random_engine re(0);
+  std::uniform_int_distribution<int64_t> dist(0, int64_t(1) << 40);
+  std::uniform_int_distribution<uint32_t> id_dist(0, entry_count - 1);
+  auto report = [&](const std::string& phase, size_t ops, double seconds) {
+    std::cout << "book " << name << " " << entry_count << " " << phase << ": " << seconds << "s, "
+              << ops / seconds / 1e6 << " Mops/s" << std::endl;
+  };
+  report("push", entry_count, measure_seconds([&]() {
+    for (uint32_t i = 0; i < entry_count; ++i) {
+      costs[i] = dist(re);
+      book.push(uint32_t(i), costs[i]);
+    }
+  }));
+  // flush the entries waiting to enter the heap.
+  book.push(uint32_t(0), costs[0]);
+  book.adjust_pop([&](const uint32_t& id) { return costs[id]; });
+  book.L = 1;
+  report("touch", entry_count, measure_seconds([&]() {
+    for (size_t i = 0; i < entry_count; ++i) {
+      book.touch(index[id_dist(re)]);
+    }
+  }));
+  size_t pops = book.size();
+  report("pop", pops, measure_seconds([&]() {
+    while (!book.empty()) {
+      book.adjust_pop([&](const uint32_t& id) { return costs[id]; });
+    }
+  }));
+}
+
+void Book() {
+  for (size_t n : book_heap_sizes) {
+    BookOps<binary_book_cfg>("binary", n);
+    BookOps<paged_book_cfg>("paged", n);
+    BookOps<dary4_book_cfg>("4-ary", n);
+    BookOps<dary8_book_cfg>("8-ary", n);
+  }
+}
+
+void Akasha() {
+  AkashaOps<SplayList<Tock, std::shared_ptr<int>>>("splay_list");
+  AkashaOps<BTreeList<Tock, std::shared_ptr<int>>>("btree");
+  AkashaOps<PageList<Tock, std::shared_ptr<int>>>("page_table");
+}
+
+// the union-find of the cost model, out of the runtime:
+// 10^7 merges of random pairs among 10^6 sets, reading every value, then sets made, merged and dropped in a sliding window.
+void UnionFind() {
+  constexpr size_t uf_count = 1'000'000;
+  constexpr size_t merge_count = 10'000'000;
+  constexpr size_t window = 1000;
+  std::default_random_engine re(0);
+  std::uniform_int_distribution<size_t> dist(0, uf_count - 1);
+  std::vector<UF<Time>> ufs;
+  ufs.reserve(uf_count);
+  for (size_t i = 0; i < uf_count; ++i) {
+    ufs.emplace_back(Time(ns(1)));
+  }
+  double seconds = measure_seconds([&]() {
+    for (size_t i = 0; i < merge_count; ++i) {
+      size_t l = dist(re), r = dist(re);
+      ufs[l].merge(ufs[r]);
+    }
+  });
+  std::cout << "union_find merge: " << seconds / merge_count * 1e9 << "ns per merge" << std::endl;
+  int64_t sum = 0;
+  seconds = measure_seconds([&]() {
+    for (const UF<Time>& uf : ufs) {
+      sum += uf.value().count();
+    }
+  });
+  std::cout << "union_find value: " << seconds / uf_count * 1e9 << "ns per value" << std::endl;
+  assert(sum > 0);
+  ufs.clear();
+
+  std::vector<UF<Time>> live;
+  live.reserve(window);
+  size_t allocations_before = allocation_count;
+  seconds = measure_seconds([&]() {
+    for (size_t i = 0; i < merge_count; ++i) {
+      if (live.size() == window) {
+        live[i % window] = UF<Time>(Time(ns(1)));
+      } else {
+        live.emplace_back(Time(ns(1)));
+      }
+      live[i % live.size()].merge(live[(i * 7) % live.size()]);
+    }
+  });
+  std::cout << "union_find churn: " << seconds / merge_count * 1e9 << "ns, "
+            << double(allocation_count - allocations_before) / merge_count << " allocations per set" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::pair<std::string, void(*)()>> benches = {
+    {"shared_scaling", &SharedScaling},
+    {"akasha", &Akasha},
+    {"allocations_per_bind", &AllocationsPerBind},
+    {"book_heap", &BookHeapBench},
+    {"book", &Book},
+    {"reclaim", &Reclaim},
+    {"eviction_fan_in", &EvictionFanIn},
+    {"approx_factor", &ApproxFactor},
+    {"eviction_policy", &EvictionPolicies},
+    {"sampled_book", &SampledBookBench},
+    {"access_recording", &AccessRecording},
+    {"union_find", &UnionFind},
+  };
+  if (argc > 2) {
+    book_heap_sizes.clear();
+    for (int i = 2; i < argc; ++i) {
+      book_heap_sizes.push_back(std::stoul(argv[i]));
+    }
+  }
+  for (const auto& [name, f] : benches) {
+    if (argc < 2 || name == argv[1]) {
+      f();
+    }
+  }
+}
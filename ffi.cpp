@@ -0,0 +1,148 @@
+// The zombie_ffi shared library: the C ABI declared in include/zombie/ffi.hpp.
+#include <vector>
+#include <optional>
+
+#include "zombie/ffi.hpp"
+#include "zombie/heap/heap.hpp"
+#include "zombie/heap/kinetic.hpp"
+
+struct EmptyNotifyHeapIndexChanged {
+  void operator()(void* const&, size_t) { }
+};
+
+struct EmptyNotifyHeapElementRemoved {
+  void operator()(void* const&) { }
+};
+
+struct CompareMinNode {
+  bool operator()(const MinNode& l, const MinNode& r) const {
+    return l.score < r.score;
+  }
+};
+
+struct NHICMinNode {
+  void operator()(const MinNode&, size_t) { }
+};
+
+struct NHERMinNode {
+  void operator()(const MinNode&) { }
+};
+
+struct KineticHanger : KineticMinHeap<void*, EmptyNotifyHeapIndexChanged, EmptyNotifyHeapElementRemoved> {
+  using KineticMinHeap::KineticMinHeap;
+};
+
+struct Heap : MinHeap<MinNode, CompareMinNode, NHICMinNode, NHERMinNode> { };
+
+namespace {
+  aff_t* until_result(const std::optional<shift_t>& until) {
+    thread_local aff_t result;
+    if (!until.has_value()) {
+      return nullptr;
+    }
+    result = until.value();
+    return &result;
+  }
+}
+
+extern "C" {
+  AffFunction* aff_function_new(slope_t slope, shift_t shift) {
+    return new AffFunction(slope, shift);
+  }
+
+  aff_t aff_function_eval(const AffFunction* aff_function, shift_t x) {
+    return (*aff_function)(x);
+  }
+
+  aff_t* aff_function_lt_until(const AffFunction* aff_function, const AffFunction* rhs) {
+    return until_result(aff_function->lt_until(*rhs));
+  }
+
+  aff_t* aff_function_le_until(const AffFunction* aff_function, const AffFunction* rhs) {
+    return until_result(aff_function->le_until(*rhs));
+  }
+
+  void aff_function_delete(AffFunction* aff_function) {
+    delete aff_function;
+  }
+
+  KineticHanger* kinetic_hanger_new(int64_t time) {
+    return new KineticHanger(time);
+  }
+
+  aff_t kinetic_hanger_cur_min_value(const KineticHanger* hanger) {
+    return hanger->cur_min_value();
+  }
+
+  size_t kinetic_hanger_size(const KineticHanger* hanger) {
+    return hanger->size();
+  }
+
+  bool kinetic_hanger_empty(const KineticHanger* hanger) {
+    return hanger->empty();
+  }
+
+  void kinetic_hanger_push(KineticHanger* hanger, void* t, const AffFunction* aff) {
+    hanger->push(t, *aff);
+  }
+
+  void* kinetic_hanger_peek(KineticHanger* hanger) {
+    return hanger->peek();
+  }
+
+  void* kinetic_hanger_index(KineticHanger* hanger, size_t i) {
+    return (*hanger)[i];
+  }
+
+  void* kinetic_hanger_pop(KineticHanger* hanger) {
+    return hanger->pop();
+  }
+
+  void* kinetic_hanger_remove(KineticHanger* hanger, size_t i) {
+    return hanger->remove(i);
+  }
+
+  int64_t kinetic_hanger_time(const KineticHanger* hanger) {
+    return hanger->time();
+  }
+
+  void kinetic_hanger_advance_to(KineticHanger* hanger, int64_t new_time) {
+    hanger->advance_to(new_time);
+  }
+
+  void kinetic_hanger_delete(KineticHanger* hanger) {
+    delete hanger;
+  }
+
+  Heap* heap_new() {
+    return new Heap();
+  }
+
+  void heap_delete(Heap* heap) {
+    delete heap;
+  }
+
+  bool heap_empty(const Heap* heap) {
+    return heap->empty();
+  }
+
+  size_t heap_size(const Heap* heap) {
+    return heap->size();
+  }
+
+  void heap_push(Heap* heap, void* t, double score) {
+    heap->push(MinNode{t, score});
+  }
+
+  double heap_peek_score(const Heap* heap) {
+    return heap->peek().score;
+  }
+
+  void* heap_peek(const Heap* heap) {
+    return heap->peek().elm;
+  }
+
+  void* heap_pop(Heap* heap) {
+    return heap->pop().elm;
+  }
+}
@@ -5,8 +5,7 @@
 #include <cassert>
 #include <fstream>
 
-constexpr bool log_info = true;
-static std::fstream log_to;
+#include "trace.hpp"
 
 template<typename A, typename B, typename C>
 decltype(std::declval<B>()()) bracket(const A& a, const B& b, const C& c) {
@@ -20,19 +20,145 @@ inline std::ostream& operator<<(std::ostream& o, const cost_t& x) {
 }
 using Metric = cost_t(*)(Time cost, Time neighbor_cost, Space size);
 
+// How Trailokya::get_trailokya() is scoped.
+// - Global: one runtime per config for the whole process. Not thread safe.
+// - ThreadLocal: every thread get its own independent runtime (and clock).
+//   Zombies must not be shared between threads in this mode.
+// - Shared: one runtime shared by all threads.
+//   Reading a resident value take no lock, everything else (bind, miss, eviction) is serialized.
+enum class RuntimeMode {
+  Global,
+  ThreadLocal,
+  Shared
+};
+
+// The ordered index behind Trailokya::akasha.
+// - SplayList: a splay tree threaded as a list. Splay on every lookup.
+// - BTree: a B+-tree with entries inline in the leaves (see BTreeList).
+// - PageTable: a direct index on the dense tock space (see PageList).
+enum class AkashaIndex {
+  SplayList,
+  BTree,
+  PageTable
+};
+
+// The container behind GDHeap, i.e. Trailokya::book.
+// - Binary: MinHeap, a flat array.
+// - Paged: BHeap, subtrees packed into pages. An operation touch fewer pages,
+//   but compute more per level: it only pay off when the book is large and page misses dominate (see `bench book_heap`).
+// - DAry: DHeap, [book_heap_arity] children per node, with the costs quantized to 64 bits in their own array.
+// - Sampled: no heap at all, see SampledBook. An access is O(1), and eviction take the best of
+//   [book_sample_size] random entries instead of the best overall.
+enum class BookHeap {
+  Binary,
+  Paged,
+  DAry,
+  Sampled
+};
+
+// How Trailokya::book rank contexts, the smallest priority being evicted first (see BookPolicy in gd_heap.hpp).
+// - Cost: the metric, as is.
+// - GreedyDual: L + metric. L rise to the priority of every victim, and an access re-base an entry on the current L,
+//   so entries not accessed for a while age out even if expensive.
+// - GDSF: L + frequency * metric, with the same L. The size is the metric's business, e.g. uf_metric divide by it.
+// - LRU: the last access time (FullContextNode::last_accessed).
+// - LFU: the number of accesses.
+enum class EvictionPolicy {
+  Cost,
+  GreedyDual,
+  GDSF,
+  LRU,
+  LFU
+};
+
 struct ZombieConfig {
   Metric metric;
   // for some varying metric, such as those concerning UF set,
   // the cost in [Trailokya::book] may not be up-to-date.
   // when the actual value is within [1/approx_factor, approx_factor] of the stored value,
   // we ignore the difference
-  // [approx_factor] is stored as a rational number as a/b here. it must be greater than 1.
+  // [approx_factor] is stored as a rational number as a/b here. it must be at least 1, {1, 1} meaning exact.
   std::pair<unsigned int, unsigned int> approx_factor;
+  RuntimeMode runtime = RuntimeMode::Global;
+  // when resident bytes (as reported by GetSize) exceed [memory_budget],
+  // the runtime evict via Trailokya::book until it fit again.
+  // 0 means no budget: eviction only happen when asked for.
+  size_t memory_budget = 0;
+  // {high, low} in bytes. once resident bytes cross high,
+  // the reclaimer evict down to low between steps (or on its own thread in RuntimeMode::Shared),
+  // so that the allocating path rarely hit [memory_budget] and evict by itself.
+  // {0, 0} disable the reclaimer.
+  std::pair<size_t, size_t> watermarks = {0, 0};
+  // how many contexts the reclaimer evict before checking for the low watermark (and releasing the lock) again.
+  size_t reclaim_batch = 16;
+  AkashaIndex akasha = AkashaIndex::SplayList;
+  BookHeap book_heap = BookHeap::Binary;
+  size_t book_heap_arity = 8;
+  size_t book_sample_size = 5;
+  EvictionPolicy eviction_policy = EvictionPolicy::Cost;
+  // allocate akasha nodes and contexts from slab pools owned by the runtime,
+  // instead of one malloc each. Contexts are not pooled in RuntimeMode::Shared,
+  // where they may be released by any thread.
+  bool pool_allocation = true;
   constexpr ZombieConfig(const Metric& metric,
                          const std::pair<unsigned int, unsigned int>& approx_factor) :
     metric(metric),
     approx_factor(approx_factor)
   { }
+
+  // the optional knobs are set by chaining on a base config, e.g.
+  //   constexpr ZombieConfig cfg = ZombieConfig(&uf_metric, {1, 1}).with_runtime(RuntimeMode::ThreadLocal);
+  constexpr ZombieConfig with_runtime(RuntimeMode mode) const {
+    ZombieConfig ret = *this;
+    ret.runtime = mode;
+    return ret;
+  }
+
+  constexpr ZombieConfig with_memory_budget(size_t bytes) const {
+    ZombieConfig ret = *this;
+    ret.memory_budget = bytes;
+    return ret;
+  }
+
+  constexpr ZombieConfig with_pool_allocation(bool pool) const {
+    ZombieConfig ret = *this;
+    ret.pool_allocation = pool;
+    return ret;
+  }
+
+  constexpr ZombieConfig with_akasha(AkashaIndex index) const {
+    ZombieConfig ret = *this;
+    ret.akasha = index;
+    return ret;
+  }
+
+  constexpr ZombieConfig with_eviction_policy(EvictionPolicy policy) const {
+    ZombieConfig ret = *this;
+    ret.eviction_policy = policy;
+    return ret;
+  }
+
+  // [arity] only matter for BookHeap::DAry.
+  constexpr ZombieConfig with_book_heap(BookHeap heap, size_t arity = 8) const {
+    ZombieConfig ret = *this;
+    ret.book_heap = heap;
+    ret.book_heap_arity = arity;
+    return ret;
+  }
+
+  constexpr ZombieConfig with_sampled_book(size_t sample = 5) const {
+    ZombieConfig ret = *this;
+    ret.book_heap = BookHeap::Sampled;
+    ret.book_sample_size = sample;
+    return ret;
+  }
+
+  constexpr ZombieConfig with_watermarks(size_t high, size_t low, size_t batch = 16) const {
+    ZombieConfig ret = *this;
+    ret.watermarks = {high, low};
+    ret.reclaim_batch = batch;
+    return ret;
+  }
 };
 
 inline cost_t local_metric(Time cost, Time neighbor_cost, Space size) {
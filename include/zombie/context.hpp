@@ -6,21 +6,34 @@
 
 namespace ZombieInternal {
 
+// a runtime's UF live in it's own arena, Trailokya::uf_arena, guarded by the runtime lock like the rest of it.
+template<const ZombieConfig& cfg>
+struct RuntimeUFArena {
+  static UFArena<Time>& get();
+};
+
+template<const ZombieConfig& cfg>
+using TimeUF = UF<Time, RuntimeUFArena<cfg>>;
+
 template<const ZombieConfig& cfg>
 struct ContextNode : Object {
   Tock start_t, end_t; // open-close
   std::vector<std::shared_ptr<EZombieNode<cfg>>> ez;
   size_t ez_space_taken;
   Replayer<cfg> end_rep;
+  // bytes counted in Trailokya::context_bytes.
+  size_t metadata_size;
 
-  UF<Time> backward_uf = UF<Time>(Time(0));
+  TimeUF<cfg> backward_uf = TimeUF<cfg>(Time(0));
 
   explicit ContextNode(const Tock& start_t, const Tock& end_t,
                        std::vector<std::shared_ptr<EZombieNode<cfg>>>&& ez,
                        const size_t& sp,
                        const Replayer<cfg>& rep);
+  ~ContextNode();
 
-  virtual void accessed() = 0;
+  // [count] accesses, the last one at [time].
+  virtual void accessed(const ns& time, size_t count) = 0;
   virtual bool evictable() = 0;
   virtual void evict() = 0;
   virtual void evict_individual(const Tock& t) = 0;
@@ -37,7 +50,7 @@ struct RootContextNode : ContextNode<cfg> {
                            std::vector<std::shared_ptr<EZombieNode<cfg>>>&& ez,
                            const size_t& sp,
                            const Replayer<cfg>& rep) : ContextNode<cfg>(start_t, end_t, std::move(ez), sp, rep) { }
-  void accessed() override { }
+  void accessed(const ns& time, size_t count) override { }
   bool evictable() override { return false; }
   void evict() override { assert(false); }
   void evict_individual(const Tock& t) override { assert(false); }
@@ -48,11 +61,18 @@ struct FullContextNode : ContextNode<cfg> {
   std::vector<Tock> dependencies;
   Time time_taken;
   mutable Time last_accessed;
+  // accesses, counting the creation.
+  size_t access_count = 1;
 
+  // where it's entry sit in Trailokya::book, kept up to date by the book.
+  // -1 once the entry left the book, waiting_index while the entry wait for an index (see GDHeap::waiting).
+  static constexpr ptrdiff_t waiting_index = -2;
   mutable ptrdiff_t pool_index = -1;
 
-  UF<Time> forward_uf = UF<Time>(Time(0));
-  UFSet<Time> backedges;
+  TimeUF<cfg> forward_uf = TimeUF<cfg>(Time(0));
+  UFSet<Time, RuntimeUFArena<cfg>> backedges;
+  // time_cost(), until a UF it read merge, a backedge is added, or a context is inserted next to one it read.
+  UFMemo<Time, RuntimeUFArena<cfg>> cost_memo;
 
   explicit FullContextNode(const Tock& start_t,
                            const Tock& end_t,
@@ -63,13 +83,15 @@ struct FullContextNode : ContextNode<cfg> {
                            std::vector<Tock>&& deps);
   ~FullContextNode();
 
-  void accessed() override;
+  void accessed(const ns& time, size_t count) override;
   bool evictable() override { return true; }
   void evict() override;
   void evict_individual(const Tock& t) override;
   Time time_cost();
   Space space_taken();
   cost_t cost();
+  // the cost Trailokya::book rank this by, under cfg.eviction_policy.
+  cost_t policy_cost();
   bool is_tailcall() override { return true; }
 };
 
@@ -1,17 +1,22 @@
 #pragma once
 
+#include <cstddef>
+
 #include "heap/aff_function.hpp"
-#include "heap/kinetic.hpp"
 
+// A C ABI over AffFunction, KineticMinHeap and MinHeap, built as the zombie_ffi shared library.
+// KineticHanger and Heap are opaque, elements are void*, owned by the caller.
 extern "C" {
-  AffFunction *aff_function_new(slope_t slope, shift_t x_shift);
+  AffFunction *aff_function_new(slope_t slope, shift_t shift);
   aff_t aff_function_eval(const AffFunction *aff_function, shift_t x);
+  // see AffFunction::lt_until and le_until. nullptr means forever,
+  // otherwise the result is valid until the next call on the same thread.
   aff_t* aff_function_lt_until(const AffFunction* aff_function, const AffFunction* rhs);
   aff_t* aff_function_le_until(const AffFunction* aff_function, const AffFunction* rhs);
   void aff_function_delete(AffFunction* aff_function);
 
-  struct EmptyNotifyHeapIndexChanged;
-  using KineticHanger = HeapImpls::KineticMinHeap<void*, true, EmptyNotifyHeapIndexChanged>;
+  // a KineticMinHeap<void*>.
+  struct KineticHanger;
 
   KineticHanger* kinetic_hanger_new(int64_t time);
   aff_t kinetic_hanger_cur_min_value(const KineticHanger* hanger);
@@ -30,10 +35,8 @@ extern "C" {
     void* elm;
     double score;
   };
-  struct CompareMinNode;
-  struct NHICMinNode;
-  struct NHERMinNode;
-  using Heap = MinNormalHeap<MinNode, CompareMinNode, NHICMinNode, NHERMinNode>;
+  // a MinHeap<MinNode>, smallest score first.
+  struct Heap;
 
   Heap* heap_new();
   void heap_delete(Heap* heap);
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <limits>
+#include <cstdint>
+#include <optional>
+
+using aff_t = int64_t;
+using slope_t = int64_t;
+using shift_t = int64_t;
+
+// f(x) = slope * x + shift, a priority drifting linearly with time, e.g. an aging cost.
+// Evaluation and crossing points are computed in 128 bits, so they do not overflow for any int64 input,
+// but eval() saturate to the aff_t range.
+struct AffFunction {
+  slope_t slope;
+  shift_t shift;
+
+  AffFunction(slope_t slope, shift_t shift) : slope(slope), shift(shift) { }
+
+  aff_t operator()(shift_t x) const {
+    __int128 y = static_cast<__int128>(slope) * x + shift;
+    if (y > std::numeric_limits<aff_t>::max()) {
+      return std::numeric_limits<aff_t>::max();
+    } else if (y < std::numeric_limits<aff_t>::min()) {
+      return std::numeric_limits<aff_t>::min();
+    } else {
+      return static_cast<aff_t>(y);
+    }
+  }
+
+  bool operator==(const AffFunction& rhs) const {
+    return slope == rhs.slope && shift == rhs.shift;
+  }
+
+  // the smallest x where this(x) > rhs(x) or (if [strict]) this(x) >= rhs(x),
+  // provided that the relation then keep holding for every larger x.
+  // i.e., if it hold at some time, it keep holding until the returned time, exclusive.
+  // nullopt if it hold forever once it hold.
+  std::optional<shift_t> until(const AffFunction& rhs, bool strict) const {
+    // this(x) - rhs(x) = ds * x + db.
+    __int128 ds = static_cast<__int128>(slope) - rhs.slope;
+    __int128 db = static_cast<__int128>(shift) - rhs.shift;
+    if (ds <= 0) {
+      // the gap never grow: once it hold, it hold.
+      return std::nullopt;
+    }
+    // smallest x with ds * x + db > 0 (or >= 0): x > -db / ds (or >=).
+    __int128 n = -db;
+    __int128 q = n / ds;
+    if (q * ds > n) {
+      // round toward minus infinity.
+      --q;
+    }
+    // q = floor(n / ds)
+    __int128 x = strict && q * ds == n ? q : q + 1;
+    if (x > std::numeric_limits<shift_t>::max()) {
+      return std::nullopt;
+    } else if (x < std::numeric_limits<shift_t>::min()) {
+      return std::numeric_limits<shift_t>::min();
+    } else {
+      return static_cast<shift_t>(x);
+    }
+  }
+
+  // when does this < rhs stop holding?
+  std::optional<shift_t> lt_until(const AffFunction& rhs) const {
+    return until(rhs, true);
+  }
+
+  // when does this <= rhs stop holding?
+  std::optional<shift_t> le_until(const AffFunction& rhs) const {
+    return until(rhs, false);
+  }
+};
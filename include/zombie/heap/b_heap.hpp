@@ -1,82 +1,329 @@
+#pragma once
+
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "heap.hpp"
+
 // In a normal binary heap, after a few level, each parent and it's children will not be in a cache line.
 // BHeap fix this problem by allocating the nodes into pages,
 // where each parent is likely to be in the same page as children.
 // the pages themselves are also organized via an implicit-tree manner, so there is no need to store index for parent/children pages.
 // note that in the canonical implementation, each page have two root pointer (except the root page), as when you reach the bottom of a page,
 // you need to look at both it's child which is in two different page.
-// this is ugly as fuck and I hate it. I will not implement it unless necessary.
-template<typename T>
+// this is ugly, but a single root per page turned out to be slower than MinHeap:
+// sink compare the two children, and at the bottom of every page they would be in two different pages.
+//
+// So a page is numbered as a heap from 1, of [level_in_page] levels, where position 1 is in the parent page:
+// it hold two sibling subtrees, at positions 2 .. 2^level_in_page - 1.
+// Every node on the bottom level of a page has it's two children as the two roots of a child page,
+// so the page tree have branching factor (1 << (level_in_page - 1)).
+// The root page is the exception, with the root of the whole heap at position 1.
+// An index is (page << level_in_page | position) - 1, so the root is 0, and finding a parent or a child is a few shifts.
+// Positions 0 and 1 of the other pages are never used, so indices are not dense:
+// use nth() to go from a rank to an index.
+// Pages are filled in order, and parent always come before children,
+// so the first size() elements form a tree, and the last one is a leaf: push and remove work exactly as in MinHeap.
+// A walk from the root to a leaf touch one page per (level_in_page - 1) levels.
+//
+// Same interface, and same NHIC/NHER contract, as MinHeap.
+template<typename T,
+         typename Compare = std::less<T>,
+         typename NHIC = NotifyHeapIndexChanged<T>,
+         typename NHER = NotifyHeapElementRemoved<T>,
+         size_t page_bytes = 4096>
 struct BHeap {
-  struct Page {
-    size_t idx;
-    std::vector<T> nodes;
-    explicit Page(size_t idx) : idx(idx) {
-      
+  static constexpr size_t default_level_in_page() {
+    size_t level = 2;
+    while ((size_t(1) << (level + 1)) * sizeof(T) <= page_bytes) {
+      ++level;
     }
-    Page() = delete;
-  };
-  std::vector<Page> pages;
-  void expand(size_t page_count) {
-    
+    return level;
   }
-  void shrink() {
-    
+
+  constexpr static size_t level_in_page = default_level_in_page();
+  constexpr static size_t slot_in_page = size_t(1) << level_in_page;
+  constexpr static size_t node_in_page = slot_in_page - 2;
+  constexpr static size_t page_branching_factor = size_t(1) << (level_in_page - 1);
+  constexpr static size_t page_alignment = std::max(page_bytes, alignof(T));
+
+  // a page is raw storage for [slot_in_page] T, the first few constructed.
+  std::vector<T*> pages;
+  size_t size_ = 0;
+  // the index of the next element pushed, i.e. nth(size()).
+  size_t end_ = 0;
+
+  static size_t index_of(size_t page, size_t position) {
+    return ((page << level_in_page) | position) - 1;
+  }
+
+  // the index of the element of rank [n] in the page filling order.
+  static size_t nth(size_t n) {
+    if (n == 0) {
+      return 0;
+    }
+    return index_of((n - 1) / node_in_page, (n - 1) % node_in_page + 2);
+  }
+
+  static size_t parent(size_t i) {
+    assert(i != 0); // root dont have parent.
+    size_t page = (i + 1) >> level_in_page;
+    size_t position = (i + 1) & (slot_in_page - 1);
+    if (position > 3 || page == 0) {
+      return index_of(page, position / 2);
+    } else {
+      size_t shifted = page - 1;
+      return index_of(shifted / page_branching_factor, page_branching_factor + shifted % page_branching_factor);
+    }
   }
 
-  constexpr static size_t level_in_page = 10;
-  constexpr static size_t node_in_page = (2 >> level_in_page) - 1;
-  constexpr static size_t page_branching_factor = (2 >> level_in_page);
-  // the page tree have branching factor (2 >> level_in_page).
+  static size_t left_child(size_t i) {
+    size_t page = (i + 1) >> level_in_page;
+    size_t position = (i + 1) & (slot_in_page - 1);
+    if (position < page_branching_factor) {
+      return index_of(page, position * 2);
+    } else {
+      return index_of(page * page_branching_factor + 1 + position - page_branching_factor, 2);
+    }
+  }
 
-  inline bool heap_is_root(size_t i) {
+  static size_t right_child(size_t i) {
+    return left_child(i) + 1;
+  }
+
+  static bool is_root(size_t i) {
     return i == 0;
   }
 
-  inline size_t heap_parent(size_t i) {
-    // Heap index calculation assume array index starting from 1.
-    return (i + 1) / 2 - 1;
+  void expand() {
+    pages.push_back(static_cast<T*>(::operator new(slot_in_page * sizeof(T), std::align_val_t(page_alignment))));
   }
 
-  inline size_t heap_left_child(size_t i) {
-    return (i + 1) * 2 - 1;
+  // keep one empty page around, so pushing and popping at a page boundary does not allocate every time.
+  void shrink() {
+    while (pages.size() > ((end_ + 1) >> level_in_page) + 1) {
+      ::operator delete(pages.back(), std::align_val_t(page_alignment));
+      pages.pop_back();
+    }
   }
 
-  inline size_t heap_right_child(size_t i) {
-    return heap_left_child(i) + 1;
+  T& peek() {
+    return (*this)[0];
   }
 
-  using std::pair<size_t, size_t> = index_t;
-  static index_t parent(const index_t& idx) {
-    size_t page_idx = idx.left;
-    size_t node_idx = idx.right;
-    if (heap_is_root(node_idx)) {
-      assert(page_idx != 0); // root node at root page dont have parent.
-      size_t shifted_idx = page_idx - 1;
-      return {shifted_idx / page_branching_factor, shifted_idx % page_branching_factor};
-    } else {
-      return {page_idx, heap_parent(node_idx);
+  const T& peek() const {
+    return (*this)[0];
+  }
+
+  T pop() {
+    return remove(0);
+  }
+
+  template<typename F>
+  void remap(const F& f) {
+    remap_recurse(f, 0);
+  }
+
+  template<typename F>
+  void remap_recurse(const F& f, size_t idx) {
+    if (has_value(idx)) {
+      f((*this)[idx]);
+      remap_recurse(f, left_child(idx));
+      remap_recurse(f, right_child(idx));
+      sink(idx, false);
     }
   }
-  static index_t left_child(const index_t& idx) {
-    size_t page_idx = idx.left;
-    size_t node_idx = idx.right;
-    size_t idx = heap_left_child(node_idx);
-    if (idx < node_in_page) {
-      return {page_idx, left_idx};
-    } else {
-      size_t page_shift = idx - node_in_page;
-      return {page_idx * page_branching_factor + 1 + page_shift, 0}
+
+  void flow(const size_t& idx, bool idx_notified) {
+    assert(has_value(idx));
+    if (!is_root(idx)) {
+      size_t pidx = parent(idx);
+      if (cmp((*this)[idx], (*this)[pidx])) {
+        swap(idx, pidx);
+        if (!idx_notified) {
+          notify_changed(idx);
+        }
+        flow(pidx, true);
+        notify_changed(pidx);
+      }
     }
   }
-  static index_t right_child(const index_t& idx) {
-    size_t page_idx = idx.left;
-    size_t node_idx = idx.right;
-    size_t idx = heap_right_child(node_idx);
-    if (idx < node_in_page) {
-      return {page_idx, left_idx};
-    } else {
-      size_t page_shift = idx - node_in_page;
-      return {page_idx * page_branching_factor + 1 + page_shift, 0}
+
+  void sink(const size_t& idx, bool idx_notified) {
+    size_t a_child_idx = left_child(idx);
+    size_t b_child_idx = right_child(idx);
+    if (has_value(a_child_idx) || has_value(b_child_idx)) {
+      size_t smaller_idx = [&](){
+        if (!has_value(a_child_idx)) {
+          return b_child_idx;
+        } else if (!has_value(b_child_idx)) {
+          return a_child_idx;
+        } else {
+          return cmp((*this)[a_child_idx], (*this)[b_child_idx]) ? a_child_idx : b_child_idx;
+        }
+      }();
+      if (cmp((*this)[smaller_idx], (*this)[idx])) {
+        swap(idx, smaller_idx);
+        if (!idx_notified) {
+          notify_changed(idx);
+        }
+        sink(smaller_idx, true);
+        notify_changed(smaller_idx);
+      }
+    }
+  }
+
+  void rebalance(const size_t& idx, bool idx_notified) {
+    assert(has_value(idx));
+    flow(idx, idx_notified);
+    sink(idx, idx_notified);
+  }
+
+  void notify_changed(const size_t& i) {
+    assert(has_value(i));
+    nhic(static_cast<const T&>((*this)[i]), i);
+  }
+
+  void notify_removed(const T& t) {
+    nher(t);
+  }
+
+  void swap(const size_t& l, const size_t& r) {
+    std::swap((*this)[l], (*this)[r]);
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  void clear() {
+    while (size_ > 0) {
+      pop_back();
+    }
+  }
+
+  template<typename U>
+  void emplace_back(U&& u) {
+    if (((end_ + 1) >> level_in_page) == pages.size()) {
+      expand();
+    }
+    new (&(*this)[end_]) T(std::forward<U>(u));
+    end_ = nth(++size_);
+  }
+
+  void pop_back() {
+    assert(size_ > 0);
+    end_ = nth(--size_);
+    (*this)[end_].~T();
+    shrink();
+  }
+
+  // the index of the last element.
+  size_t back() const {
+    assert(size_ > 0);
+    return nth(size_ - 1);
+  }
+
+  void push(const T& t) {
+    emplace_back(t);
+    flow(back(), true);
+    notify_changed(back());
+  }
+
+  void push(T&& t) {
+    emplace_back(std::move(t));
+    flow(back(), true);
+    notify_changed(back());
+  }
+
+  bool has_value(const size_t& idx) const {
+    return idx < end_;
+  }
+
+  const T& operator[](const size_t& idx) const {
+    assert(((idx + 1) >> level_in_page) < pages.size());
+    return pages[(idx + 1) >> level_in_page][(idx + 1) & (slot_in_page - 1)];
+  }
+
+  T& operator[](const size_t& idx) {
+    assert(((idx + 1) >> level_in_page) < pages.size());
+    return pages[(idx + 1) >> level_in_page][(idx + 1) & (slot_in_page - 1)];
+  }
+
+  T remove_no_rebalance(const size_t& idx) {
+    assert(has_value(idx));
+    T ret = std::move((*this)[idx]);
+    swap(idx, back());
+    pop_back();
+    notify_removed(ret);
+    return ret;
+  }
+
+  T remove(const size_t& idx) {
+    T ret = remove_no_rebalance(idx);
+    if (has_value(idx)) {
+      rebalance(idx, true);
+      notify_changed(idx);
+    }
+    return ret;
+  }
+
+  void heapify() {
+    heapify_recurse(0);
+  }
+
+  void heapify_recurse(size_t idx) {
+    if (has_value(idx)) {
+      heapify_recurse(left_child(idx));
+      heapify_recurse(right_child(idx));
+      sink(idx, false);
+    }
+  }
+
+  template<typename F, typename O>
+  void remove_if(const F& f, const O& o) {
+    size_t n = 0;
+    while (n < size_) {
+      if (f((*this)[nth(n)])) {
+        o(remove_no_rebalance(nth(n)));
+      } else {
+        ++n;
+      }
+    }
+    heapify();
+  }
+
+  Compare cmp;
+  NHIC nhic;
+  NHER nher;
+
+  BHeap(const Compare& cmp = Compare(),
+        const NHIC& nhic = NHIC(),
+        const NHER& nher = NHER()) : cmp(cmp), nhic(nhic), nher(nher) { }
+
+  BHeap(const BHeap&) = delete;
+  BHeap& operator=(const BHeap&) = delete;
+
+  ~BHeap() {
+    clear();
+    for (T* page : pages) {
+      ::operator delete(page, std::align_val_t(page_alignment));
+    }
+  }
+
+  std::vector<T> values() const {
+    std::vector<T> ret;
+    ret.reserve(size_);
+    for (size_t n = 0; n < size_; ++n) {
+      ret.push_back((*this)[nth(n)]);
     }
+    return ret;
   }
 };
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <new>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <utility>
+
+#include "heap.hpp"
+
+// allocate from cache line boundaries, so a block of children keys is a single line.
+template<typename T, size_t alignment = 64>
+struct CacheLineAllocator {
+  using value_type = T;
+
+  CacheLineAllocator() { }
+  template<typename U>
+  CacheLineAllocator(const CacheLineAllocator<U, alignment>&) { }
+
+  template<typename U>
+  struct rebind {
+    using other = CacheLineAllocator<U, alignment>;
+  };
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+  }
+
+  void deallocate(T* p, size_t) {
+    ::operator delete(p, std::align_val_t(alignment));
+  }
+
+  template<typename U>
+  bool operator==(const CacheLineAllocator<U, alignment>&) const { return true; }
+  template<typename U>
+  bool operator!=(const CacheLineAllocator<U, alignment>&) const { return false; }
+};
+
+// A d-ary heap with the priorities in their own array (struct of arrays).
+// Every element has a 64 bit key, given by KeyOf, which must be monotone with Compare:
+// key(l) < key(r) imply cmp(l, r). Keys are compared first, and only on a tie do we look at the elements.
+// So a key can be a quantized (e.g. saturated) priority and the order stay exact,
+// as long as ties are rare.
+// Finding the smallest child look at [arity] contiguous keys: with arity 8 that is one cache line,
+// and the loop is branch free, so it can be vectorized. Elements are only touched when they move.
+//
+// Same interface, and same NHIC/NHER contract, as MinHeap.
+// After modifying an element via operator[], rebalance() it: that also refresh it's key.
+template<typename T,
+         typename KeyOf,
+         size_t arity = 8,
+         typename Compare = std::less<T>,
+         typename NHIC = NotifyHeapIndexChanged<T>,
+         typename NHER = NotifyHeapElementRemoved<T>>
+struct DHeap {
+  static_assert(arity >= 2);
+
+  // key of element i is at keys[i + padding]: the children of i, from arity * i + 1, then start on a multiple of arity.
+  static constexpr size_t padding = arity - 1;
+
+  std::vector<uint64_t, CacheLineAllocator<uint64_t>> keys = std::vector<uint64_t, CacheLineAllocator<uint64_t>>(padding);
+  std::vector<T> arr;
+
+  static size_t parent(size_t i) {
+    return (i - 1) / arity;
+  }
+
+  static size_t first_child(size_t i) {
+    return arity * i + 1;
+  }
+
+  static size_t nth(size_t n) {
+    return n;
+  }
+
+  uint64_t& key(size_t i) {
+    return keys[i + padding];
+  }
+
+  uint64_t key(size_t i) const {
+    return keys[i + padding];
+  }
+
+  bool less(size_t l, size_t r) const {
+    return key(l) != key(r) ? key(l) < key(r) : cmp(arr[l], arr[r]);
+  }
+
+  // the smallest of the children of [idx], which must have one.
+  size_t smallest_child(size_t idx) const {
+    size_t begin = first_child(idx);
+    size_t end = std::min(begin + arity, arr.size());
+    const uint64_t* k = &keys[begin + padding];
+    size_t best = 0;
+    uint64_t best_key = k[0];
+    bool tie = false;
+    for (size_t i = 1; i < end - begin; ++i) {
+      bool smaller = k[i] < best_key;
+      tie |= k[i] == best_key;
+      best = smaller ? i : best;
+      best_key = smaller ? k[i] : best_key;
+    }
+    if (tie) {
+      // rare: redo it with the elements breaking ties.
+      best = 0;
+      for (size_t i = 1; i < end - begin; ++i) {
+        if (less(begin + i, begin + best)) {
+          best = i;
+        }
+      }
+    }
+    return begin + best;
+  }
+
+  T& peek() {
+    return (*this)[0];
+  }
+
+  const T& peek() const {
+    return (*this)[0];
+  }
+
+  T pop() {
+    return remove(0);
+  }
+
+  template<typename F>
+  void remap(const F& f) {
+    for (size_t i = 0; i < arr.size(); ++i) {
+      f(arr[i]);
+      key(i) = key_of(arr[i]);
+    }
+    heapify();
+  }
+
+  // is the element [t] of key [k] smaller than the element at [i]?
+  bool less(uint64_t k, const T& t, size_t i) const {
+    return k != key(i) ? k < key(i) : cmp(t, arr[i]);
+  }
+
+  // flow and sink move a hole instead of swapping, so every element on the way is moved once.
+  // Like MinHeap, every index whose element changed is notified, except [idx] if [idx_notified].
+  void flow(const size_t& idx, bool idx_notified) {
+    assert(has_value(idx));
+    if (heap_is_root(idx) || !less(idx, parent(idx))) {
+      return;
+    }
+    T t = std::move(arr[idx]);
+    uint64_t k = key(idx);
+    size_t i = idx;
+    do {
+      size_t p = parent(i);
+      arr[i] = std::move(arr[p]);
+      key(i) = key(p);
+      if (i != idx || !idx_notified) {
+        notify_changed(i);
+      }
+      i = p;
+    } while (!heap_is_root(i) && less(k, t, parent(i)));
+    arr[i] = std::move(t);
+    key(i) = k;
+    notify_changed(i);
+  }
+
+  void sink(const size_t& idx, bool idx_notified) {
+    assert(has_value(idx));
+    if (first_child(idx) >= arr.size()) {
+      return;
+    }
+    size_t c = smallest_child(idx);
+    if (!less(c, idx)) {
+      return;
+    }
+    T t = std::move(arr[idx]);
+    uint64_t k = key(idx);
+    size_t i = idx;
+    while (true) {
+      arr[i] = std::move(arr[c]);
+      key(i) = key(c);
+      if (i != idx || !idx_notified) {
+        notify_changed(i);
+      }
+      i = c;
+      if (first_child(i) >= arr.size()) {
+        break;
+      }
+      c = smallest_child(i);
+      if (key(c) != k ? key(c) > k : !cmp(arr[c], t)) {
+        break;
+      }
+    }
+    arr[i] = std::move(t);
+    key(i) = k;
+    notify_changed(i);
+  }
+
+  void rebalance(const size_t& idx, bool idx_notified) {
+    assert(has_value(idx));
+    key(idx) = key_of(arr[idx]);
+    flow(idx, idx_notified);
+    sink(idx, idx_notified);
+  }
+
+  void notify_changed(const size_t& i) {
+    assert(has_value(i));
+    nhic(static_cast<const T&>(arr[i]), i);
+  }
+
+  void notify_removed(const T& t) {
+    nher(t);
+  }
+
+  void swap(const size_t& l, const size_t& r) {
+    std::swap(arr[l], arr[r]);
+    std::swap(key(l), key(r));
+  }
+
+  bool empty() const {
+    return arr.empty();
+  }
+
+  size_t size() const {
+    return arr.size();
+  }
+
+  void clear() {
+    arr.clear();
+    keys.resize(padding);
+  }
+
+  void push(const T& t) {
+    push(T(t));
+  }
+
+  void push(T&& t) {
+    keys.push_back(key_of(t));
+    arr.push_back(std::move(t));
+    flow(arr.size() - 1, true);
+    notify_changed(arr.size() - 1);
+  }
+
+  bool has_value(const size_t& idx) const {
+    return idx < arr.size();
+  }
+
+  const T& operator[](const size_t& idx) const {
+    assert(has_value(idx));
+    return arr[idx];
+  }
+
+  T& operator[](const size_t& idx) {
+    assert(has_value(idx));
+    return arr[idx];
+  }
+
+  T remove_no_rebalance(const size_t& idx) {
+    assert(has_value(idx));
+    T ret = std::move(arr[idx]);
+    swap(idx, arr.size() - 1);
+    arr.pop_back();
+    keys.pop_back();
+    notify_removed(ret);
+    return ret;
+  }
+
+  T remove(const size_t& idx) {
+    T ret = remove_no_rebalance(idx);
+    if (idx < arr.size()) {
+      rebalance(idx, true);
+      notify_changed(idx);
+    }
+    return ret;
+  }
+
+  void heapify() {
+    for (size_t i = arr.size(); i-- > 0;) {
+      sink(i, false);
+    }
+  }
+
+  template<typename F, typename O>
+  void remove_if(const F& f, const O& o) {
+    size_t idx = 0;
+    while (idx < arr.size()) {
+      if (f(arr[idx])) {
+        o(remove_no_rebalance(idx));
+      } else {
+        ++idx;
+      }
+    }
+    heapify();
+  }
+
+  Compare cmp;
+  NHIC nhic;
+  NHER nher;
+  KeyOf key_of;
+
+  DHeap(const Compare& cmp = Compare(),
+        const NHIC& nhic = NHIC(),
+        const NHER& nher = NHER(),
+        const KeyOf& key_of = KeyOf()) : cmp(cmp), nhic(nhic), nher(nher), key_of(key_of) { }
+
+  std::vector<T> values() const {
+    return arr;
+  }
+};
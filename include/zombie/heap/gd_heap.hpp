@@ -1,9 +1,49 @@
+// The hooks of an EvictionPolicy into GDHeap.
+// An entry's priority is cost + L_: the cost is what RecomputeLater::cost() report for the policy
+// (see FullContextNode::policy_cost), and the policy decide L_ and how L move.
+// - on_insert: the L_ of a new entry.
+// - on_touch: the L_ of an entry just accessed. touched() tell whether it change at all.
+// - choose_victim: which of [n] candidates of fresh [priority] to evict, moving L past it.
+//   SampledBook offer it it's whole sample. GDHeap already order the entries by that priority,
+//   so it only offer the fresh top: a policy ranking victims by anything else need the SampledBook.
+// A policy only ever let the true priority of an entry grow while it sit in the heap
+// (a new access, a merged UF), so a stale entry is re-costed lazily, once it reach the top.
+template<EvictionPolicy policy>
+struct BookPolicy {
+  // L inflation, as in Greedy-Dual.
+  static constexpr bool aging = policy == EvictionPolicy::GreedyDual || policy == EvictionPolicy::GDSF;
+  // approx_factor is a tolerance on costs, it would be meaningless on times and counts.
+  static constexpr bool approximate = policy != EvictionPolicy::LRU && policy != EvictionPolicy::LFU;
+  // LRU and LFU only bump the cost, which adjust_pop pick up lazily.
+  static constexpr bool touched = policy != EvictionPolicy::LRU && policy != EvictionPolicy::LFU;
+
+  static cost_t on_insert(const cost_t& L) {
+    return aging ? L : 0;
+  }
+
+  static cost_t on_touch(const cost_t& L, const cost_t& L_) {
+    return touched ? L : L_;
+  }
+
+  static size_t choose_victim(cost_t& L, const cost_t* priority, size_t n) {
+    assert(n > 0);
+    size_t victim = std::min_element(priority, priority + n) - priority;
+    if (aging) {
+      L = std::max(L, priority[victim]);
+    }
+    return victim;
+  }
+};
+
 template<const ZombieConfig& cfg,
          typename T,
          typename NHIC = NotifyHeapIndexChanged<T>,
          typename NHER = NotifyHeapElementRemoved<T>>
 struct GDHeap {
-  static constexpr bool staleness = false;
+  using Policy = BookPolicy<cfg.eviction_policy>;
+  // new entries go straight into the heap, and L move at every pop.
+  // otherwise they are batched in [waiting], and L stay at 0.
+  static constexpr bool staleness = Policy::aging;
 
   struct Node {
     T t;
@@ -17,6 +57,28 @@ struct GDHeap {
     Node& operator=(Node&&) = default;
   };
   cost_t L = 0;
+  // times adjust_pop found a stale cost and pushed the entry back.
+  size_t repush_count = 0;
+  // times adjust_pop found a stale cost, but within approx_factor, and took the entry anyway.
+  size_t repush_avoided_count = 0;
+
+  // is [new_cost] within [1/approx_factor, approx_factor] of [old_cost]?
+  // costs of opposite sign are never close. with approx_factor {1, 1} only an equal cost is.
+  static bool approx_equal(const cost_t& old_cost, const cost_t& new_cost) {
+    constexpr auto a = cfg.approx_factor.first, b = cfg.approx_factor.second;
+    static_assert(a >= b, "approx_factor must not be below 1");
+    if (old_cost == new_cost) {
+      return true;
+    } else if constexpr (a == b || !Policy::approximate) {
+      return false;
+    } else {
+      if ((old_cost < 0) != (new_cost < 0)) {
+        return false;
+      }
+      cost_t o = old_cost < 0 ? -old_cost : old_cost, n = new_cost < 0 ? -new_cost : new_cost;
+      return o * b <= n * a && n * b <= o * a;
+    }
+  }
 
   struct NHIC_INNER {
     NHIC nhic;
@@ -34,7 +96,21 @@ struct GDHeap {
     }
   };
 
-  MinHeap<Node, std::less<Node>, NHIC_INNER, NHER_INNER> heap;
+  // cost + L_, saturated to 64 bits, order preserving. DHeap compare the Node on a tie, so the order stay exact.
+  struct NodeKey {
+    uint64_t operator()(const Node& n) const {
+      cost_t c = n.cost + n.L_;
+      c = std::clamp<cost_t>(c, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max());
+      return static_cast<uint64_t>(static_cast<int64_t>(c)) ^ (uint64_t(1) << 63);
+    }
+  };
+
+  using Heap = std::conditional_t<cfg.book_heap == BookHeap::Paged,
+                                  BHeap<Node, std::less<Node>, NHIC_INNER, NHER_INNER>,
+                                  std::conditional_t<cfg.book_heap == BookHeap::DAry,
+                                                     DHeap<Node, NodeKey, cfg.book_heap_arity, std::less<Node>, NHIC_INNER, NHER_INNER>,
+                                                     MinHeap<Node, std::less<Node>, NHIC_INNER, NHER_INNER>>>;
+  Heap heap;
   std::vector<Node> waiting;
 
   GDHeap(const NHIC& nhic = NHIC(), const NHER& nher = NHER()) : heap(std::less<Node>(), NHIC_INNER(nhic), NHER_INNER(nher)) { }
@@ -42,9 +118,7 @@ struct GDHeap {
   void readjust() {
     if (!staleness) {
       if (waiting.size() * waiting.size() > heap.size()) {
-        if (log_info) {
-          std::cout << "readjust! " << std::endl;
-        }
+        ZOMBIE_TRACE(TraceLevel::Debug, TraceKind::HeapReadjust, waiting.size(), heap.size());
         for (Node& n: waiting) {
           heap.push(std::move(n));
         }
@@ -56,7 +130,7 @@ struct GDHeap {
   bool fix(const std::function<cost_t(const T&)>& cost_f) {
     std::default_random_engine re;
     std::uniform_int_distribution<int> uniform_dist(0, heap.size() - 1);
-    size_t i = uniform_dist(re);
+    size_t i = heap.nth(uniform_dist(re));
     Node& n = heap[i];
     cost_t new_cost = cost_f(n.t);
     if (n.cost != new_cost) {
@@ -78,19 +152,20 @@ struct GDHeap {
       assert(!heap.empty());
       Node n = heap.pop();
       cost_t new_cost = cost_f(n.t);
-      //if (n.cost / cfg.approx_factor.first <= new_cost / cfg.approx_factor.second &&
-      //    new_cost / cfg.approx_factor.first <= n.cost / cfg.approx_factor.second) {
-      if (n.cost == new_cost) {
-        if (log_info) {
-          std::cout << "popped " << n.cost << ", " << n.L_ << std::endl;
+      if (approx_equal(n.cost, new_cost)) {
+        if (n.cost != new_cost) {
+          ++repush_avoided_count;
         }
-        if (staleness) {
-          L = std::max(L, n.cost + n.L_);
-        } else {
+        ZOMBIE_TRACE(TraceLevel::Debug, TraceKind::HeapPop, static_cast<int64_t>(n.cost), static_cast<int64_t>(n.L_), heap.size());
+        cost_t priority = n.cost + n.L_;
+        [[maybe_unused]] size_t victim = Policy::choose_victim(L, &priority, 1);
+        assert(victim == 0);
+        if (!staleness) {
           readjust();
         }
         return std::move(n.t);
       } else {
+        ++repush_count;
         n.cost = new_cost;
         heap.push(std::move(n));
       }
@@ -115,16 +190,60 @@ struct GDHeap {
       // weird. doesnt work.
       // L += cost;
       // std::cout << "L is: " << L << std::endl;
-      heap.push(Node(std::move(t), cost, L));
+      heap.push(Node(std::move(t), cost, Policy::on_insert(L)));
     } else {
-      waiting.push_back(Node(std::move(t), cost, L));
+      waiting.push_back(Node(std::move(t), cost, Policy::on_insert(L)));
       readjust();
     }
   }
 
   void touch(size_t idx) {
-    heap[idx].L_ = L;
-    heap.rebalance(idx, true);
-    heap.notify_changed(idx);
+    if constexpr (Policy::touched) {
+      heap[idx].L_ = Policy::on_touch(L, heap[idx].L_);
+      heap.rebalance(idx, true);
+      heap.notify_changed(idx);
+    }
+  }
+
+  // take out the entry at [idx] without evicting it.
+  T remove(size_t idx) {
+    return std::move(heap.remove(idx).t);
+  }
+
+  // the same, for entries still in waiting, which have no index: remove those [f] hold for.
+  template<typename F>
+  size_t remove_unindexed_if(const F& f) {
+    size_t removed = 0;
+    for (size_t i = 0; i < waiting.size();) {
+      if (f(waiting[i].t)) {
+        heap.notify_removed(waiting[i]);
+        if (i + 1 != waiting.size()) {
+          waiting[i] = std::move(waiting.back());
+        }
+        waiting.pop_back();
+        ++removed;
+      } else {
+        ++i;
+      }
+    }
+    return removed;
+  }
+
+  template<typename F>
+  size_t count_if(const F& f) {
+    size_t ret = 0;
+    for (size_t i = 0; i < heap.size(); ++i) {
+      ret += f(heap[heap.nth(i)].t);
+    }
+    for (const Node& n : waiting) {
+      ret += f(n.t);
+    }
+    return ret;
+  }
+
+  // take out every entry without evicting them.
+  void clear() {
+    remove_unindexed_if([](const T&) { return true; });
+    heap.remove_if([](const Node&) { return true; }, [](Node&&) { });
   }
 };
@@ -153,6 +153,11 @@ struct MinHeap {
     return idx < arr.size();
   }
 
+  // the index of the element of rank [n], for heaps with holes such as BHeap.
+  static size_t nth(size_t n) {
+    return n;
+  }
+
   const T& operator[](const size_t& idx) const {
     assert(has_value(idx));
     return arr[idx];
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "heap.hpp"
+#include "aff_function.hpp"
+
+// A kinetic min heap: every element has an AffFunction as priority, and the heap is ordered by their value at time().
+// Instead of recomputing every priority when time move, each parent/child edge hold a certificate,
+// the time at which the parent stop being <= the child (see AffFunction::le_until).
+// Certificates are kept in a MinHeap by failure time, so advance_to() only touch the edges that actually flip:
+// swap the two elements, then recompute the few certificates around them.
+//
+// With ZOMBIE_KINETIC_VERIFY_INVARIANT defined, every operation check the heap order and every certificate, in O(n).
+template<typename T,
+         typename NHIC = NotifyHeapIndexChanged<T>,
+         typename NHER = NotifyHeapElementRemoved<T>>
+struct KineticMinHeap {
+  static constexpr aff_t never = std::numeric_limits<aff_t>::max();
+
+  struct Node {
+    T t;
+    AffFunction f;
+    Node(T&& t, const AffFunction& f) : t(std::move(t)), f(f) { }
+  };
+
+  // the edge between [idx] and it's parent break at [fail_at].
+  struct Certificate {
+    aff_t fail_at;
+    size_t idx;
+    bool operator<(const Certificate& rhs) const {
+      return fail_at < rhs.fail_at;
+    }
+  };
+
+  struct CertificateMoved {
+    KineticMinHeap* self;
+    void operator()(const Certificate& c, size_t idx) {
+      self->certificate_index[c.idx] = idx;
+    }
+  };
+
+  struct CertificateRemoved {
+    void operator()(const Certificate&) { }
+  };
+
+  aff_t time_;
+  std::vector<Node> arr;
+  // where the certificate of the edge above [i] is in [certificates]. unused for the root.
+  std::vector<size_t> certificate_index;
+  MinHeap<Certificate, std::less<Certificate>, CertificateMoved, CertificateRemoved> certificates;
+  NHIC nhic;
+  NHER nher;
+
+  explicit KineticMinHeap(aff_t time, const NHIC& nhic = NHIC(), const NHER& nher = NHER()) :
+    time_(time),
+    certificates(std::less<Certificate>(), CertificateMoved{this}, CertificateRemoved()),
+    nhic(nhic),
+    nher(nher) { }
+
+  // certificates point back to this.
+  KineticMinHeap(const KineticMinHeap&) = delete;
+  KineticMinHeap& operator=(const KineticMinHeap&) = delete;
+
+  aff_t time() const {
+    return time_;
+  }
+
+  bool empty() const {
+    return arr.empty();
+  }
+
+  size_t size() const {
+    return arr.size();
+  }
+
+  bool has_value(size_t idx) const {
+    return idx < arr.size();
+  }
+
+  aff_t value(size_t idx) const {
+    assert(has_value(idx));
+    return arr[idx].f(time_);
+  }
+
+  aff_t cur_min_value() const {
+    return value(0);
+  }
+
+  const T& peek() const {
+    return (*this)[0];
+  }
+
+  T& peek() {
+    return (*this)[0];
+  }
+
+  const T& operator[](size_t idx) const {
+    assert(has_value(idx));
+    return arr[idx].t;
+  }
+
+  T& operator[](size_t idx) {
+    assert(has_value(idx));
+    return arr[idx].t;
+  }
+
+  const AffFunction& function(size_t idx) const {
+    assert(has_value(idx));
+    return arr[idx].f;
+  }
+
+  // an edge that is already broken (only transiently, in the middle of an operation) fail now.
+  aff_t fail_at(size_t idx) const {
+    assert(!heap_is_root(idx));
+    size_t p = heap_parent(idx);
+    if (value(p) > value(idx)) {
+      return time_;
+    }
+    return arr[p].f.le_until(arr[idx].f).value_or(never);
+  }
+
+  void refresh_certificate(size_t idx) {
+    if (has_value(idx) && !heap_is_root(idx)) {
+      size_t c = certificate_index[idx];
+      certificates[c].fail_at = fail_at(idx);
+      certificates.rebalance(c, false);
+    }
+  }
+
+  // the edges touching [idx]: above it, and to it's children.
+  void refresh_around(size_t idx) {
+    refresh_certificate(idx);
+    refresh_certificate(heap_left_child(idx));
+    refresh_certificate(heap_right_child(idx));
+  }
+
+  void notify_changed(size_t idx) {
+    nhic(static_cast<const T&>(arr[idx].t), idx);
+  }
+
+  // swap with the parent, and fix every certificate that might have changed.
+  void swap_with_parent(size_t idx) {
+    size_t p = heap_parent(idx);
+    std::swap(arr[idx], arr[p]);
+    notify_changed(idx);
+    notify_changed(p);
+    // the edges around p include the one to the sibling of idx.
+    refresh_around(idx);
+    refresh_around(p);
+  }
+
+  bool less(size_t l, size_t r) const {
+    aff_t lv = value(l), rv = value(r);
+    // on a tie, the one that grow slower is smaller from now on.
+    return lv != rv ? lv < rv : arr[l].f.slope < arr[r].f.slope;
+  }
+
+  void flow(size_t idx) {
+    while (!heap_is_root(idx) && less(idx, heap_parent(idx))) {
+      swap_with_parent(idx);
+      idx = heap_parent(idx);
+    }
+  }
+
+  void sink(size_t idx) {
+    while (true) {
+      size_t l = heap_left_child(idx), r = heap_right_child(idx);
+      size_t smallest = idx;
+      if (has_value(l) && less(l, smallest)) {
+        smallest = l;
+      }
+      if (has_value(r) && less(r, smallest)) {
+        smallest = r;
+      }
+      if (smallest == idx) {
+        return;
+      }
+      swap_with_parent(smallest);
+      idx = smallest;
+    }
+  }
+
+  void push(T&& t, const AffFunction& f) {
+    arr.push_back(Node(std::move(t), f));
+    size_t idx = arr.size() - 1;
+    certificate_index.push_back(0);
+    if (!heap_is_root(idx)) {
+      certificates.push(Certificate{fail_at(idx), idx});
+    }
+    notify_changed(idx);
+    flow(idx);
+    verify_invariant();
+  }
+
+  void push(const T& t, const AffFunction& f) {
+    push(T(t), f);
+  }
+
+  T remove(size_t idx) {
+    assert(has_value(idx));
+    size_t last = arr.size() - 1;
+    if (idx != last) {
+      std::swap(arr[idx], arr[last]);
+    }
+    T ret = std::move(arr[last].t);
+    arr.pop_back();
+    if (!heap_is_root(last)) {
+      certificates.remove(certificate_index[last]);
+    }
+    certificate_index.pop_back();
+    nher(ret);
+    if (idx != last) {
+      notify_changed(idx);
+      refresh_around(idx);
+      flow(idx);
+      sink(idx);
+    }
+    verify_invariant();
+    return ret;
+  }
+
+  T pop() {
+    return remove(0);
+  }
+
+  // move time forward to [new_time], fixing the order one failed certificate at a time.
+  void advance_to(aff_t new_time) {
+    assert(new_time >= time_);
+    while (!certificates.empty() && certificates.peek().fail_at <= new_time) {
+      Certificate c = certificates.peek();
+      time_ = std::max(time_, c.fail_at);
+      // when several edges fail at once, a swap can break a neighbouring edge:
+      // it's certificate then fail now, and is handled by the next iteration.
+      swap_with_parent(c.idx);
+    }
+    time_ = new_time;
+    verify_invariant();
+  }
+
+  void verify_invariant() const {
+#ifdef ZOMBIE_KINETIC_VERIFY_INVARIANT
+    assert(certificates.size() + (arr.empty() ? 0 : 1) == arr.size());
+    for (size_t i = 1; i < arr.size(); ++i) {
+      assert(value(heap_parent(i)) <= value(i));
+      const Certificate& c = certificates[certificate_index[i]];
+      assert(c.idx == i);
+      assert(c.fail_at == fail_at(i));
+      assert(c.fail_at > time_);
+    }
+#endif
+  }
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <random>
+#include <cassert>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+// An approximate book, like Redis's approximate LRU/LFU: no heap, the entries sit in a flat array in no order.
+// Touching an entry is O(1) and write nothing but the entry itself
+// (the context already record it's access time and count before touching).
+// adjust_pop() sample [cfg.book_sample_size] entries at random, compute their fresh cost,
+// and take the cheapest: eviction cost O(sample) cost evaluations, and is only as good as the sample.
+//
+// Same interface as GDHeap, ranking by BookPolicy<cfg.eviction_policy>,
+// and the same NHIC/NHER contract: an entry moved by a removal is notified of it's new index.
+template<const ZombieConfig& cfg,
+         typename T,
+         typename NHIC = NotifyHeapIndexChanged<T>,
+         typename NHER = NotifyHeapElementRemoved<T>>
+struct SampledBook {
+  using Policy = BookPolicy<cfg.eviction_policy>;
+  static_assert(cfg.book_sample_size > 0);
+
+  struct Node {
+    T t;
+    cost_t cost;
+    cost_t L_;
+    Node(T&& t_, cost_t cost_, cost_t L__) : t(std::move(t_)), cost(cost_), L_(L__) { }
+    Node(Node&&) = default;
+    Node& operator=(Node&&) = default;
+  };
+
+  std::vector<Node> arr;
+  cost_t L = 0;
+  // kept for ZombieStats: nothing is ever pushed back.
+  size_t repush_count = 0;
+  size_t repush_avoided_count = 0;
+  std::default_random_engine re;
+  NHIC nhic;
+  NHER nher;
+
+  SampledBook(const NHIC& nhic = NHIC(), const NHER& nher = NHER()) : nhic(nhic), nher(nher) { }
+
+  bool empty() const {
+    return arr.empty();
+  }
+
+  size_t size() const {
+    return arr.size();
+  }
+
+  void push(T&& t, const cost_t& cost) {
+    arr.push_back(Node(std::move(t), cost, Policy::on_insert(L)));
+    nhic(arr.back().t, arr.size() - 1);
+  }
+
+  void touch(size_t idx) {
+    assert(idx < arr.size());
+    arr[idx].L_ = Policy::on_touch(L, arr[idx].L_);
+  }
+
+  T remove(size_t idx) {
+    assert(idx < arr.size());
+    T ret = std::move(arr[idx].t);
+    if (idx + 1 != arr.size()) {
+      arr[idx] = std::move(arr.back());
+      nhic(arr[idx].t, idx);
+    }
+    arr.pop_back();
+    nher(ret);
+    return ret;
+  }
+
+  // every entry has an index.
+  template<typename F>
+  size_t remove_unindexed_if(const F&) {
+    return 0;
+  }
+
+  template<typename F>
+  size_t count_if(const F& f) {
+    size_t ret = 0;
+    for (const Node& n : arr) {
+      ret += f(n.t);
+    }
+    return ret;
+  }
+
+  void clear() {
+    while (!arr.empty()) {
+      remove(arr.size() - 1);
+    }
+  }
+
+  // the candidates are the whole book while it fit in a sample, and a random sample otherwise.
+  // the policy choose among them (BookPolicy::choose_victim).
+  T adjust_pop(const std::function<cost_t(const T&)>& cost_f) {
+    assert(!arr.empty());
+    std::array<size_t, cfg.book_sample_size> index;
+    std::array<cost_t, cfg.book_sample_size> priority;
+    size_t n = std::min(arr.size(), cfg.book_sample_size);
+    std::uniform_int_distribution<size_t> dist(0, arr.size() - 1);
+    for (size_t i = 0; i < n; ++i) {
+      index[i] = arr.size() <= cfg.book_sample_size ? i : dist(re);
+      Node& node = arr[index[i]];
+      node.cost = cost_f(node.t);
+      priority[i] = node.cost + node.L_;
+    }
+    return remove(index[Policy::choose_victim(L, priority.data(), n)]);
+  }
+};
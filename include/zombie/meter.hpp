@@ -31,6 +31,8 @@ struct ZombieClock {
     forwarded += n;
   }
 
+  // the process wide clock, shared by the runtimes several threads may use, so their readings compare.
+  // a RuntimeMode::ThreadLocal runtime keep it's own instead (see Trailokya::clock).
   static ZombieClock& singleton() {
     static ZombieClock zc;
     return zc;
@@ -41,26 +43,32 @@ struct ZombieClock {
 // This class take care of that.
 struct ZombieMeter {
   struct Node {
-    ns constructed_time = ZombieClock::singleton().time();
+    const ZombieClock* clock;
+    ns constructed_time;
     ns skipping_time = ns(0);
 
+    explicit Node(const ZombieClock& clock) : clock(&clock), constructed_time(clock.time()) { }
+
     ns time() {
-      return ZombieClock::singleton().time() - skipping_time;
+      return clock->time() - skipping_time;
     }
   };
 
-  std::vector<Node> stack { Node() };
+  ZombieClock& clock;
+  std::vector<Node> stack;
+
+  explicit ZombieMeter(ZombieClock& clock = ZombieClock::singleton()) : clock(clock), stack { Node(clock) } { }
 
   ns time() {
     return stack.back().time();
   }
 
   ns raw_time() const {
-    return ZombieClock::singleton().time();
+    return clock.time();
   }
 
   void fast_forward(ns n) {
-    ZombieClock::singleton().fast_forward(n);
+    clock.fast_forward(n);
   }
 
   template<typename F>
@@ -76,7 +84,7 @@ struct ZombieMeter {
 
   template<typename F>
   decltype(std::declval<F>()()) block(const F& f) {
-    return bracket([&]() { stack.push_back(Node()); },
+    return bracket([&]() { stack.push_back(Node(clock)); },
                    f,
                    [&]() {
                      assert(!stack.empty());
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <limits>
+#include <utility>
+#include <optional>
+#include <cassert>
+#include <unordered_map>
+#include <algorithm>
+
+#include "zombie_impl.hpp"
+
+namespace ZombieInternal {
+
+// A value held by a RecomputePlan while a later step read it:
+// the reaper pass over the context holding it instead of evicting it (see Phantom::pinned).
+// by tock, so it can be taken before the value come back, and cover the context bringing it back from the start.
+template<const ZombieConfig& cfg>
+struct ValuePin {
+  // empty once moved from.
+  std::optional<Tock> tock;
+
+  explicit ValuePin(const Tock& tock) : tock(tock) {
+    Trailokya<cfg>::get_trailokya().pinned_tocks.push_back(tock);
+  }
+  ValuePin(const ValuePin&) = delete;
+  ValuePin(ValuePin&& rhs) : tock(std::exchange(rhs.tock, std::nullopt)) { }
+  ~ValuePin() {
+    if (tock) {
+      auto& pinned = Trailokya<cfg>::get_trailokya().pinned_tocks;
+      auto it = std::find(pinned.begin(), pinned.end(), *tock);
+      assert(it != pinned.end());
+      if (it != pinned.end()) {
+        *it = pinned.back();
+        pinned.pop_back();
+      }
+    }
+  }
+};
+
+// One replay of a RecomputePlan: [replay_from] is the context replayed, bringing back [values].
+template<const ZombieConfig& cfg>
+struct RecomputeStep {
+  std::vector<EZombie<cfg>> values;
+  Tock replay_from;
+  // the time_taken of the context replayed over, when it is still in akasha.
+  // once evicted, only the neighbour cost merged into [replay_from]'s backward_uf is left, which bound it from above.
+  Time estimated_time = Time(0);
+  // what bringing the values back a second time could cost, if they are not kept:
+  // this replay, and the replays of it's inputs, were they gone too.
+  Time recompute_time = Time(0);
+  // the steps bringing back the inputs of the replayed bind that are missing, all before this one.
+  // the inputs of the binds it tailcall into are only known once replayed, and rematerialized as usual then.
+  std::vector<size_t> inputs;
+  // the last step reading a value of this one: it is kept resident until then, when the pin budget allow.
+  // npos for a step bringing back a target, kept until the plan is done.
+  size_t last_use = 0;
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+};
+
+// How to bring back a set of values, decided before replaying anything.
+// A value come back by replaying the context ending before it (replay_context), so there is no checkpoint to choose.
+// What is left to decide is the order, and what to keep:
+// the steps are in dependency order, each replay done once however many values it bring back,
+// and the values a later step read are pinned until that step, so eviction cannot send them back to be recomputed.
+// Pins hold memory the runtime cannot reclaim, so the intermediates pinned at once fit in [pin_budget]:
+// as their size is only known once they are back, execute() decide as it go,
+// keeping the ones most expensive to recompute (RecomputeStep::recompute_time),
+// and leaving the others to be evicted and recomputed if they have to.
+// The targets are kept pinned regardless, until the plan is done.
+template<const ZombieConfig& cfg>
+struct RecomputePlan {
+  std::vector<EZombie<cfg>> targets;
+  std::vector<RecomputeStep<cfg>> steps;
+  // bytes of intermediates execute() may keep pinned. by default what the runtime must stay under, if anything.
+  size_t pin_budget = cfg.memory_budget != 0 ? cfg.memory_budget :
+                      cfg.watermarks.first != 0 ? cfg.watermarks.first :
+                      std::numeric_limits<size_t>::max();
+
+  bool empty() const {
+    return steps.empty();
+  }
+
+  Time estimated_time() const {
+    Time ret = Time(0);
+    for (const auto& step : steps) {
+      ret += step.estimated_time;
+    }
+    return ret;
+  }
+
+  // run the steps, and return the targets, in order.
+  std::vector<std::shared_ptr<EZombieNode<cfg>>> execute() const;
+};
+
+template<const ZombieConfig& cfg>
+struct RecomputePlanner {
+  Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+  RecomputePlan<cfg> plan;
+  // step of the context replayed from, by it's start_t.
+  std::unordered_map<Tock, size_t> step_of;
+
+  // the step bringing back [z] once it's inputs have theirs, or npos if it is resident.
+  size_t visit(const EZombie<cfg>& z) {
+    if (!z.evicted()) {
+      return RecomputeStep<cfg>::npos;
+    }
+    Context<cfg> from = replay_context<cfg>(z.created_time);
+    auto it = step_of.find(from->start_t);
+    if (it != step_of.end()) {
+      plan.steps[it->second].values.push_back(z);
+      return it->second;
+    }
+    RecomputeStep<cfg> step;
+    step.values.push_back(z);
+    step.replay_from = from->start_t;
+    auto* n = t.akasha.find_le_node(z.created_time);
+    auto* within = dynamic_cast<FullContextNode<cfg>*>(n->v.get());
+    if (within != nullptr && !(within->end_t < z.created_time)) {
+      step.estimated_time = within->time_taken;
+    } else {
+      step.estimated_time = from->backward_uf.value();
+    }
+    if (from->end_rep) {
+      for (const EZombie<cfg>& input : from->end_rep->in) {
+        size_t i = visit(input);
+        if (i != RecomputeStep<cfg>::npos) {
+          step.inputs.push_back(i);
+        }
+      }
+    }
+    step.recompute_time = step.estimated_time;
+    size_t idx = plan.steps.size();
+    for (size_t i : step.inputs) {
+      plan.steps[i].last_use = idx;
+      step.recompute_time += plan.steps[i].recompute_time;
+    }
+    plan.steps.push_back(std::move(step));
+    step_of.emplace(from->start_t, idx);
+    return idx;
+  }
+};
+
+// inspect what bringing back [targets] would replay, without replaying anything.
+template<const ZombieConfig& cfg>
+RecomputePlan<cfg> plan_recompute(const std::vector<EZombie<cfg>>& targets) {
+  auto guard = Trailokya<cfg>::get_trailokya().lock();
+  RecomputePlanner<cfg> planner;
+  planner.plan.targets = targets;
+  std::vector<size_t> target_steps;
+  for (const EZombie<cfg>& z : targets) {
+    target_steps.push_back(planner.visit(z));
+  }
+  for (size_t i : target_steps) {
+    if (i != RecomputeStep<cfg>::npos) {
+      planner.plan.steps[i].last_use = RecomputeStep<cfg>::npos;
+    }
+  }
+  return std::move(planner.plan);
+}
+
+template<const ZombieConfig& cfg>
+std::vector<std::shared_ptr<EZombieNode<cfg>>> RecomputePlan<cfg>::execute() const {
+  auto& t = Trailokya<cfg>::get_trailokya();
+  auto guard = t.lock();
+  std::vector<std::vector<ValuePin<cfg>>> pins(steps.size());
+  // bytes of the intermediates still pinned, by step.
+  std::vector<size_t> pinned_bytes(steps.size(), 0);
+  size_t pinned_total = 0;
+  auto unpin = [&](size_t j) {
+    pins[j].clear();
+    pinned_total -= pinned_bytes[j];
+    pinned_bytes[j] = 0;
+  };
+  for (size_t i = 0; i < steps.size(); ++i) {
+    // pinned first: the replay step() between records, and the reclaimer may run then.
+    for (const EZombie<cfg>& z : steps[i].values) {
+      pins[i].emplace_back(z.created_time);
+    }
+    size_t bytes = 0;
+    const auto& values = steps[i].values;
+    for (auto it = values.begin(); it != values.end(); ++it) {
+      auto ptr = it->shared_ptr();
+      // a value asked for twice is only held once.
+      if (std::none_of(values.begin(), it, [&](const EZombie<cfg>& z) { return z.created_time == it->created_time; })) {
+        bytes += ptr->get_size();
+      }
+    }
+    for (size_t j : steps[i].inputs) {
+      if (steps[j].last_use == i) {
+        unpin(j);
+      }
+    }
+    if (steps[i].last_use == RecomputeStep<cfg>::npos) {
+      continue;
+    }
+    // make room by dropping the pins of cheaper intermediates, cheapest first, if that is enough.
+    size_t cheaper_bytes = 0;
+    for (size_t j = 0; j < i; ++j) {
+      if (steps[j].recompute_time < steps[i].recompute_time) {
+        cheaper_bytes += pinned_bytes[j];
+      }
+    }
+    if (pinned_total - cheaper_bytes + bytes > pin_budget) {
+      pins[i].clear();
+      continue;
+    }
+    while (pinned_total + bytes > pin_budget) {
+      size_t cheapest = i;
+      for (size_t j = 0; j < i; ++j) {
+        if (pinned_bytes[j] != 0 && steps[j].recompute_time < steps[cheapest].recompute_time) {
+          cheapest = j;
+        }
+      }
+      unpin(cheapest);
+    }
+    pinned_bytes[i] = bytes;
+    pinned_total += bytes;
+  }
+  std::vector<std::shared_ptr<EZombieNode<cfg>>> ret;
+  for (const EZombie<cfg>& z : targets) {
+    ret.push_back(z.shared_ptr());
+  }
+  return ret;
+}
+
+} // end of namespace ZombieInternal
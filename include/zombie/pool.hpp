@@ -0,0 +1,150 @@
+#pragma once
+
+#include <new>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cassert>
+
+// Fixed size allocation with free list reuse.
+// Memory is carved from slabs, and only given back to the system all at once, when the pool is destroyed.
+// Not thread safe.
+struct SlabPool {
+  static constexpr size_t alignment = alignof(std::max_align_t);
+  static constexpr size_t slab_bytes = 64 * 1024;
+
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  size_t object_size;
+  size_t objects_per_slab;
+  std::vector<void*> slabs;
+  FreeNode* free_list = nullptr;
+  // objects handed out and not yet given back.
+  size_t live = 0;
+
+  explicit SlabPool(size_t size) :
+    object_size((std::max(size, sizeof(FreeNode)) + alignment - 1) / alignment * alignment),
+    objects_per_slab(std::max<size_t>(slab_bytes / object_size, 1)) { }
+
+  SlabPool(const SlabPool&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+
+  ~SlabPool() {
+    // with objects still out, they would point into freed memory: leak instead.
+    if (live == 0) {
+      for (void* slab : slabs) {
+        ::operator delete(slab, std::align_val_t(alignment));
+      }
+    }
+  }
+
+  void* allocate() {
+    if (free_list == nullptr) {
+      char* slab = static_cast<char*>(::operator new(object_size * objects_per_slab, std::align_val_t(alignment)));
+      slabs.push_back(slab);
+      for (size_t i = objects_per_slab; i-- > 0;) {
+        FreeNode* n = reinterpret_cast<FreeNode*>(slab + i * object_size);
+        n->next = free_list;
+        free_list = n;
+      }
+    }
+    FreeNode* ret = free_list;
+    free_list = ret->next;
+    ++live;
+    return ret;
+  }
+
+  void deallocate(void* p) {
+    assert(live > 0);
+    FreeNode* n = static_cast<FreeNode*>(p);
+    n->next = free_list;
+    free_list = n;
+    --live;
+  }
+
+  size_t reserved_bytes() const {
+    return slabs.size() * objects_per_slab * object_size;
+  }
+};
+
+// A SlabPool per size class, for objects of several types.
+// The owner calls release() instead of deleting it:
+// the arena is freed at once if nothing is allocated from it anymore,
+// otherwise when the last outstanding object is deallocated.
+struct SlabArena {
+  static constexpr size_t granularity = SlabPool::alignment;
+
+  std::vector<std::unique_ptr<SlabPool>> pools;
+  size_t live = 0;
+  bool released = false;
+
+  SlabPool& pool_for(size_t bytes) {
+    size_t c = (bytes + granularity - 1) / granularity;
+    if (c >= pools.size()) {
+      pools.resize(c + 1);
+    }
+    if (!pools[c]) {
+      pools[c] = std::make_unique<SlabPool>(c * granularity);
+    }
+    return *pools[c];
+  }
+
+  void* allocate(size_t bytes) {
+    ++live;
+    return pool_for(bytes).allocate();
+  }
+
+  void deallocate(void* p, size_t bytes) {
+    pool_for(bytes).deallocate(p);
+    --live;
+    if (released && live == 0) {
+      delete this;
+    }
+  }
+
+  void release() {
+    released = true;
+    if (live == 0) {
+      delete this;
+    }
+  }
+
+  size_t reserved_bytes() const {
+    size_t ret = 0;
+    for (const auto& p : pools) {
+      if (p) {
+        ret += p->reserved_bytes();
+      }
+    }
+    return ret;
+  }
+};
+
+// a std allocator on a SlabArena, e.g. for std::allocate_shared.
+template<typename T>
+struct ArenaAllocator {
+  using value_type = T;
+
+  SlabArena* arena;
+
+  explicit ArenaAllocator(SlabArena* arena) : arena(arena) { }
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U>& rhs) : arena(rhs.arena) { }
+
+  T* allocate(size_t n) {
+    static_assert(alignof(T) <= SlabPool::alignment);
+    return static_cast<T*>(arena->allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    arena->deallocate(p, n * sizeof(T));
+  }
+
+  template<typename U>
+  bool operator==(const ArenaAllocator<U>& rhs) const { return arena == rhs.arena; }
+  template<typename U>
+  bool operator!=(const ArenaAllocator<U>& rhs) const { return arena != rhs.arena; }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+#include "config.hpp"
+
+// A snapshot of a runtime's counters, taken by Trailokya::stats().
+// Counters are cumulative since the runtime was created, except where noted as current.
+struct ZombieStats {
+  // current: values held in memory, and their total size as given by GetSize.
+  size_t resident_bytes = 0;
+  size_t resident_values = 0;
+  // current: estimated bytes of bookkeeping, i.e. contexts, akasha nodes, eviction heap entries and UF nodes.
+  size_t metadata_bytes = 0;
+  // current: contexts in akasha, evicted ones excluded.
+  size_t contexts = 0;
+  // EZombie::shared_ptr() served by a resident value vs. by rematerializing it.
+  // In RuntimeMode::Shared, lock free hits of other threads are only counted once they next take the lock.
+  size_t hits = 0;
+  size_t rematerializations = 0;
+  // contexts replayed, counting nested replays.
+  size_t replays = 0;
+  // the deepest nesting of replays seen, 1 for a replay that did not need another.
+  size_t max_replay_depth = 0;
+  size_t evictions = 0;
+  // entries GDHeap::adjust_pop found with a stale cost and pushed back.
+  size_t adjust_pop_repushes = 0;
+  // entries found with a stale cost, but within ZombieConfig::approx_factor, so not pushed back.
+  size_t adjust_pop_repushes_avoided = 0;
+  // FullContextNode::time_cost() computed from scratch vs. served by it's memo.
+  size_t cost_evaluations = 0;
+  size_t cost_memo_hits = 0;
+  // current: entries in the eviction heap, and its L.
+  size_t heap_size = 0;
+  cost_t L = 0;
+  // entries taken out of the eviction heap as their context was destroyed without being evicted.
+  size_t book_entries_removed = 0;
+  // current: entries in the eviction heap whose context is gone, evicting nothing once popped.
+  // Counted by walking the heap.
+  size_t heap_tombstones = 0;
+  // time spent in top level rematerialization.
+  Time recompute_time = Time(0);
+};
@@ -0,0 +1,431 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+
+#include "common.hpp"
+
+// A B+-tree with the interface of SplayList, selected by ZombieConfig::akasha.
+// Entries are stored inline in the leaves, which are chained as a list,
+// so predecessor search and neighbour walks touch few cache lines and no splaying is needed.
+// Appending in key order (the common case for tocks) fill leaves completely.
+//
+// Unlike SplayList, a Node* is only valid until the next insert or remove.
+// Node::prev()/next() give the neighbouring nodes in key order, like SplayList's parent/children.
+template<typename K, typename V, size_t leaf_capacity = 32, size_t inner_capacity = 64>
+struct BTreeList {
+  static_assert(leaf_capacity >= 4 && inner_capacity >= 4);
+
+  struct Leaf;
+  struct Inner;
+
+  struct Base {
+    Inner* up = nullptr;
+    bool is_leaf;
+    explicit Base(bool is_leaf) : is_leaf(is_leaf) { }
+  };
+
+  struct Node {
+    K k;
+    V v;
+    Leaf* leaf = nullptr;
+
+    size_t idx() const {
+      return this - leaf->entries.data();
+    }
+
+    Node* prev() const {
+      size_t i = idx();
+      if (i > 0) {
+        return &leaf->entries[i - 1];
+      } else {
+        return leaf->prev_leaf == nullptr ? nullptr : leaf->prev_leaf->last();
+      }
+    }
+
+    Node* next() const {
+      size_t i = idx();
+      if (i + 1 < leaf->count) {
+        return &leaf->entries[i + 1];
+      } else {
+        return leaf->next_leaf == nullptr ? nullptr : &leaf->next_leaf->entries[0];
+      }
+    }
+  };
+
+  // never empty while in the tree.
+  struct Leaf : Base {
+    size_t count = 0;
+    Leaf* prev_leaf = nullptr;
+    Leaf* next_leaf = nullptr;
+    std::array<Node, leaf_capacity> entries;
+
+    Leaf() : Base(true) {
+      for (Node& n : entries) {
+        n.leaf = this;
+      }
+    }
+
+    Node* last() {
+      assert(count > 0);
+      return &entries[count - 1];
+    }
+
+    // the entry at [i] and above are moved up by one.
+    void insert_at(size_t i, const K& k, const V& v) {
+      assert(count < leaf_capacity);
+      for (size_t j = count; j > i; --j) {
+        entries[j].k = std::move(entries[j - 1].k);
+        entries[j].v = std::move(entries[j - 1].v);
+      }
+      entries[i].k = k;
+      entries[i].v = v;
+      ++count;
+    }
+
+    // move entries [from, count) to the front of an empty leaf.
+    void move_tail_to(size_t from, Leaf* to) {
+      assert(to->count == 0);
+      for (size_t j = from; j < count; ++j) {
+        to->entries[j - from].k = std::move(entries[j].k);
+        to->entries[j - from].v = std::move(entries[j].v);
+      }
+      to->count = count - from;
+      count = from;
+    }
+
+    // first entry with key > k.
+    size_t upper_bound(const K& k) const {
+      return std::upper_bound(entries.begin(), entries.begin() + count, k,
+                              [](const K& k, const Node& n) { return k < n.k; }) - entries.begin();
+    }
+  };
+
+  // keys[i] is the separator between children[i - 1] and children[i], for i > 0:
+  // every key under children[i] lie in [keys[i], keys[i + 1]).
+  struct Inner : Base {
+    size_t count = 0;
+    std::array<K, inner_capacity> keys;
+    std::array<Base*, inner_capacity> children;
+
+    Inner() : Base(false) { }
+
+    size_t child_for(const K& k) const {
+      size_t i = std::upper_bound(keys.begin() + 1, keys.begin() + count, k) - keys.begin();
+      return i - 1;
+    }
+
+    size_t index_of(const Base* child) const {
+      size_t i = std::find(children.begin(), children.begin() + count, child) - children.begin();
+      assert(i < count);
+      return i;
+    }
+
+    void insert_at(size_t i, const K& k, Base* child) {
+      assert(count < inner_capacity);
+      for (size_t j = count; j > i; --j) {
+        keys[j] = std::move(keys[j - 1]);
+        children[j] = children[j - 1];
+      }
+      keys[i] = k;
+      children[i] = child;
+      child->up = this;
+      ++count;
+    }
+
+    void remove_at(size_t i) {
+      for (size_t j = i; j + 1 < count; ++j) {
+        keys[j] = std::move(keys[j + 1]);
+        children[j] = children[j + 1];
+      }
+      --count;
+    }
+  };
+
+  Base* root = nullptr;
+  // the last leaf found and its key range, checked before descending from the root.
+  // reset whenever the shape of the tree change.
+  mutable Leaf* finger = nullptr;
+  mutable bool finger_has_lo = false, finger_has_hi = false;
+  mutable K finger_lo, finger_hi;
+  size_t size = 0;
+  size_t leaf_count = 0;
+  size_t inner_count = 0;
+
+  BTreeList() { }
+  BTreeList(const BTreeList&) = delete;
+  BTreeList& operator=(const BTreeList&) = delete;
+
+  ~BTreeList() {
+    Base* root_copy = root;
+    root = nullptr;
+    finger = nullptr;
+    size = 0;
+    if (root_copy != nullptr) {
+      free_subtree(root_copy);
+    }
+  }
+
+  static void free_subtree(Base* b) {
+    if (b->is_leaf) {
+      delete static_cast<Leaf*>(b);
+    } else {
+      Inner* in = static_cast<Inner*>(b);
+      for (size_t i = 0; i < in->count; ++i) {
+        free_subtree(in->children[i]);
+      }
+      delete in;
+    }
+  }
+
+  // bytes taken by the tree nodes, the entries included.
+  size_t memory_bytes() const {
+    return leaf_count * sizeof(Leaf) + inner_count * sizeof(Inner);
+  }
+
+  // the leaf whose range contain k. nullptr on an empty tree.
+  Leaf* find_leaf(const K& k) const {
+    if (finger != nullptr &&
+        (!finger_has_lo || !(k < finger_lo)) &&
+        (!finger_has_hi || k < finger_hi)) {
+      return finger;
+    }
+    Base* b = root;
+    if (b == nullptr) {
+      return nullptr;
+    }
+    finger_has_lo = finger_has_hi = false;
+    while (!b->is_leaf) {
+      Inner* in = static_cast<Inner*>(b);
+      size_t i = in->child_for(k);
+      if (i > 0) {
+        finger_has_lo = true;
+        finger_lo = in->keys[i];
+      }
+      if (i + 1 < in->count) {
+        finger_has_hi = true;
+        finger_hi = in->keys[i + 1];
+      }
+      b = in->children[i];
+    }
+    finger = static_cast<Leaf*>(b);
+    return finger;
+  }
+
+  // find the largest Node with key <= k.
+  Node* find_le_node(const K& k) const {
+    Leaf* leaf = find_leaf(k);
+    if (leaf == nullptr) {
+      return nullptr;
+    }
+    size_t i = leaf->upper_bound(k);
+    if (i > 0) {
+      return &leaf->entries[i - 1];
+    } else {
+      // every key in leaf's range below k got removed.
+      return leaf->prev_leaf == nullptr ? nullptr : leaf->prev_leaf->last();
+    }
+  }
+
+  Node* find_precise_node(const K& k) const {
+    Node* ptr = find_le_node(k);
+    return (ptr == nullptr || ptr->k != k) ? nullptr : ptr;
+  }
+
+  V* find_le(const K& k) {
+    Node* ptr = find_le_node(k);
+    return ptr == nullptr ? nullptr : &(ptr->v);
+  }
+
+  bool has_le(const K& k) {
+    return find_le_node(k) != nullptr;
+  }
+
+  V* find_precise(const K& k) {
+    Node* ptr = find_precise_node(k);
+    return ptr == nullptr ? nullptr : &(ptr->v);
+  }
+
+  bool has_precise(const K& k) {
+    return find_precise_node(k) != nullptr;
+  }
+
+  void insert(const K& k, const V& v) {
+    if (root == nullptr) {
+      Leaf* leaf = new Leaf();
+      ++leaf_count;
+      leaf->insert_at(0, k, v);
+      root = leaf;
+      ++size;
+      return;
+    }
+    Leaf* leaf = find_leaf(k);
+    size_t i = leaf->upper_bound(k);
+    if (i > 0 && leaf->entries[i - 1].k == k) {
+      leaf->entries[i - 1].v = v;
+      return;
+    }
+    ++size;
+    if (leaf->count < leaf_capacity) {
+      leaf->insert_at(i, k, v);
+      return;
+    }
+    finger = nullptr;
+    Leaf* right = new Leaf();
+    ++leaf_count;
+    right->prev_leaf = leaf;
+    right->next_leaf = leaf->next_leaf;
+    if (leaf->next_leaf != nullptr) {
+      leaf->next_leaf->prev_leaf = right;
+    }
+    leaf->next_leaf = right;
+    if (right->next_leaf == nullptr && i == leaf->count) {
+      // appending: keep the left leaf full.
+      right->insert_at(0, k, v);
+    } else {
+      size_t mid = leaf_capacity / 2;
+      leaf->move_tail_to(mid, right);
+      if (i <= mid) {
+        leaf->insert_at(i, k, v);
+      } else {
+        right->insert_at(i - mid, k, v);
+      }
+    }
+    insert_after(leaf, right->entries[0].k, right);
+  }
+
+  // link [right] into the tree as the next sibling of [left].
+  void insert_after(Base* left, const K& k, Base* right) {
+    Inner* parent = left->up;
+    if (parent == nullptr) {
+      Inner* new_root = new Inner();
+      ++inner_count;
+      new_root->insert_at(0, K(), left);
+      new_root->insert_at(1, k, right);
+      root = new_root;
+      return;
+    }
+    size_t i = parent->index_of(left) + 1;
+    if (parent->count < inner_capacity) {
+      parent->insert_at(i, k, right);
+      return;
+    }
+    Inner* sibling = new Inner();
+    ++inner_count;
+    if (i == parent->count) {
+      // appending: keep the left node full.
+      sibling->insert_at(0, k, right);
+      insert_after(parent, k, sibling);
+      return;
+    }
+    size_t mid = inner_capacity / 2;
+    for (size_t j = mid; j < parent->count; ++j) {
+      sibling->insert_at(j - mid, parent->keys[j], parent->children[j]);
+    }
+    K sibling_key = parent->keys[mid];
+    parent->count = mid;
+    if (i <= mid) {
+      parent->insert_at(i, k, right);
+    } else {
+      sibling->insert_at(i - mid, k, right);
+    }
+    insert_after(parent, sibling_key, sibling);
+  }
+
+  void remove_precise(const K& k) {
+    Node* ptr = find_precise_node(k);
+    if (ptr != nullptr) {
+      remove(ptr);
+    }
+  }
+
+  void remove_le(const K& k) {
+    Node* ptr = find_le_node(k);
+    if (ptr != nullptr) {
+      remove(ptr);
+    }
+  }
+
+  void remove(Node* ptr) {
+    Leaf* leaf = ptr->leaf;
+    size_t i = ptr->idx();
+    // destroyed only once the tree is consistent again, as its destructor may look at the tree.
+    V removed = std::move(ptr->v);
+    for (size_t j = i; j + 1 < leaf->count; ++j) {
+      leaf->entries[j].k = std::move(leaf->entries[j + 1].k);
+      leaf->entries[j].v = std::move(leaf->entries[j + 1].v);
+    }
+    --leaf->count;
+    leaf->entries[leaf->count].v = V();
+    --size;
+    if (leaf->count == 0) {
+      remove_leaf(leaf);
+    } else if (leaf->count <= leaf_capacity / 4) {
+      // merge into a sibling under the same parent, when that leave the result at most half full.
+      if (leaf->next_leaf != nullptr && leaf->next_leaf->up == leaf->up &&
+          leaf->count + leaf->next_leaf->count <= leaf_capacity / 2) {
+        merge_leaves(leaf, leaf->next_leaf);
+      } else if (leaf->prev_leaf != nullptr && leaf->prev_leaf->up == leaf->up &&
+                 leaf->count + leaf->prev_leaf->count <= leaf_capacity / 2) {
+        merge_leaves(leaf->prev_leaf, leaf);
+      }
+    }
+  }
+
+  // move all of right into left, then drop right.
+  void merge_leaves(Leaf* left, Leaf* right) {
+    finger = nullptr;
+    for (size_t j = 0; j < right->count; ++j) {
+      left->entries[left->count + j].k = std::move(right->entries[j].k);
+      left->entries[left->count + j].v = std::move(right->entries[j].v);
+    }
+    left->count += right->count;
+    right->count = 0;
+    remove_leaf(right);
+  }
+
+  void remove_leaf(Leaf* leaf) {
+    assert(leaf->count == 0);
+    if (leaf->prev_leaf != nullptr) {
+      leaf->prev_leaf->next_leaf = leaf->next_leaf;
+    }
+    if (leaf->next_leaf != nullptr) {
+      leaf->next_leaf->prev_leaf = leaf->prev_leaf;
+    }
+    finger = nullptr;
+    remove_child(leaf);
+  }
+
+  // unlink and free [b], then any inner node left without children.
+  void remove_child(Base* b) {
+    Inner* parent = b->up;
+    if (parent != nullptr) {
+      parent->remove_at(parent->index_of(b));
+    }
+    if (b->is_leaf) {
+      delete static_cast<Leaf*>(b);
+      --leaf_count;
+    } else {
+      delete static_cast<Inner*>(b);
+      --inner_count;
+    }
+    if (parent == nullptr) {
+      root = nullptr;
+      return;
+    }
+    if (parent->count == 0) {
+      remove_child(parent);
+      return;
+    }
+    // shrink the height while the root has a single child.
+    while (!root->is_leaf && static_cast<Inner*>(root)->count == 1) {
+      Inner* old_root = static_cast<Inner*>(root);
+      root = old_root->children[0];
+      root->up = nullptr;
+      delete old_root;
+      --inner_count;
+    }
+  }
+};
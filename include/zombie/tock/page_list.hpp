@@ -0,0 +1,315 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <type_traits>
+
+#include "common.hpp"
+
+// A direct index over the dense tock space, with the interface of SplayList, selected by ZombieConfig::akasha.
+// Tocks come from a single counter, so instead of comparing keys we split the key into a page number and an offset.
+// The directory map a page number to its page, and an occupied bit per page let lookups skip empty pages 64 at a time.
+// A page hold a bitmap of the offsets present and the entries, sorted.
+// The rank of an offset in the bitmap is its position among the entries.
+// So find_le_node is a few popcounts in the common case, with no rebalancing or splaying.
+// A page is freed as soon as its last entry is removed.
+// The directory (a pointer and a bit per page) start at page [base], and is rebased past it's empty leading pages
+// once they are most of it, so it follow the live keys rather than growing with the largest key ever inserted.
+//
+// Keys must be non negative. Like BTreeList, a Node* is only valid until the next insert or remove.
+template<typename K, typename V, size_t page_bits = 7>
+struct PageList {
+  static constexpr size_t page_size = size_t(1) << page_bits;
+  static constexpr size_t words_per_page = page_size / 64;
+  static_assert(page_bits >= 6, "a page is a whole number of bitmap words");
+
+  static uint64_t index_of(const Tock& k) {
+    assert(k.tock >= 0);
+    return k.tock;
+  }
+
+  template<typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+  static uint64_t index_of(const I& k) {
+    assert(k >= 0);
+    return k;
+  }
+
+  struct Page;
+
+  struct Node {
+    K k;
+    V v;
+    Page* page;
+
+    Node(const K& k, const V& v, Page* page) : k(k), v(v), page(page) { }
+
+    size_t idx() const {
+      return this - page->entries.data();
+    }
+
+    Node* prev() const {
+      size_t i = idx();
+      if (i > 0) {
+        return &page->entries[i - 1];
+      }
+      Page* p = page->owner->page_before(page->number);
+      return p == nullptr ? nullptr : &p->entries.back();
+    }
+
+    Node* next() const {
+      size_t i = idx();
+      if (i + 1 < page->entries.size()) {
+        return &page->entries[i + 1];
+      }
+      Page* p = page->owner->page_after(page->number);
+      return p == nullptr ? nullptr : &p->entries.front();
+    }
+  };
+
+  // never empty while in the directory.
+  struct Page {
+    PageList* owner;
+    size_t number;
+    std::array<uint64_t, words_per_page> bits = {};
+    std::vector<Node> entries;
+
+    Page(PageList* owner, size_t number) : owner(owner), number(number) { }
+
+    bool test(size_t offset) const {
+      return (bits[offset / 64] >> (offset % 64)) & 1;
+    }
+
+    // number of entries with an offset < [offset].
+    size_t rank(size_t offset) const {
+      size_t ret = 0;
+      size_t word = offset / 64;
+      for (size_t i = 0; i < word; ++i) {
+        ret += __builtin_popcountll(bits[i]);
+      }
+      uint64_t mask = (uint64_t(1) << (offset % 64)) - 1;
+      return ret + __builtin_popcountll(bits[word] & mask);
+    }
+  };
+
+  // pages[i] is the page numbered base + i. base is a multiple of 64, so occupied words align with numbers.
+  std::vector<Page*> pages;
+  // bit i is set iff pages[i] != nullptr.
+  std::vector<uint64_t> occupied;
+  size_t base = 0;
+  // occupied words before the first non zero one.
+  size_t leading_words = 0;
+  size_t size = 0;
+  size_t page_count = 0;
+
+  PageList() { }
+  PageList(const PageList&) = delete;
+  PageList& operator=(const PageList&) = delete;
+
+  ~PageList() {
+    std::vector<Page*> pages_copy;
+    std::swap(pages_copy, pages);
+    occupied.clear();
+    base = 0;
+    leading_words = 0;
+    size = 0;
+    page_count = 0;
+    for (Page* p : pages_copy) {
+      delete p;
+    }
+  }
+
+  size_t memory_bytes() const {
+    size_t ret = pages.capacity() * sizeof(Page*) + occupied.capacity() * sizeof(uint64_t);
+    for (Page* p : pages) {
+      if (p != nullptr) {
+        ret += sizeof(Page) + p->entries.capacity() * sizeof(Node);
+      }
+    }
+    return ret;
+  }
+
+  // the page numbered [number] in the directory, or nullptr.
+  // a number below base wrap around, past the end.
+  Page* page_of(size_t number) const {
+    size_t i = number - base;
+    return i < pages.size() ? pages[i] : nullptr;
+  }
+
+  // the closest non empty page numbered below [number].
+  Page* page_before(size_t number) const {
+    if (number <= base || pages.empty()) {
+      return nullptr;
+    }
+    size_t i = std::min(number - 1 - base, pages.size() - 1);
+    size_t word = i / 64;
+    uint64_t w = occupied[word] & (~uint64_t(0) >> (63 - i % 64));
+    while (w == 0) {
+      if (word == 0) {
+        return nullptr;
+      }
+      w = occupied[--word];
+    }
+    return pages[word * 64 + 63 - __builtin_clzll(w)];
+  }
+
+  // the closest non empty page numbered above [number].
+  Page* page_after(size_t number) const {
+    size_t i = number + 1 < base ? 0 : number + 1 - base;
+    if (i >= pages.size()) {
+      return nullptr;
+    }
+    size_t word = i / 64;
+    uint64_t w = occupied[word] & (~uint64_t(0) << (i % 64));
+    while (w == 0) {
+      if (++word == occupied.size()) {
+        return nullptr;
+      }
+      w = occupied[word];
+    }
+    return pages[word * 64 + __builtin_ctzll(w)];
+  }
+
+  // find the largest Node with key <= k.
+  Node* find_le_node(const K& k) const {
+    uint64_t idx = index_of(k);
+    size_t number = idx >> page_bits;
+    if (Page* p = page_of(number)) {
+      size_t offset = idx % page_size;
+      // entries with an offset <= [offset].
+      size_t r = p->rank(offset) + p->test(offset);
+      if (r > 0) {
+        return &p->entries[r - 1];
+      }
+    }
+    Page* p = page_before(number);
+    return p == nullptr ? nullptr : &p->entries.back();
+  }
+
+  Node* find_precise_node(const K& k) const {
+    uint64_t idx = index_of(k);
+    size_t number = idx >> page_bits;
+    Page* p = page_of(number);
+    if (p != nullptr && p->test(idx % page_size)) {
+      return &p->entries[p->rank(idx % page_size)];
+    }
+    return nullptr;
+  }
+
+  V* find_le(const K& k) {
+    Node* ptr = find_le_node(k);
+    return ptr == nullptr ? nullptr : &(ptr->v);
+  }
+
+  bool has_le(const K& k) {
+    return find_le_node(k) != nullptr;
+  }
+
+  V* find_precise(const K& k) {
+    Node* ptr = find_precise_node(k);
+    return ptr == nullptr ? nullptr : &(ptr->v);
+  }
+
+  bool has_precise(const K& k) {
+    return find_precise_node(k) != nullptr;
+  }
+
+  void insert(const K& k, const V& v) {
+    uint64_t idx = index_of(k);
+    size_t number = idx >> page_bits;
+    size_t offset = idx % page_size;
+    if (pages.empty()) {
+      base = number / 64 * 64;
+    } else if (number < base) {
+      // below every live key, e.g. a context replayed after the directory was rebased past it.
+      size_t new_base = number / 64 * 64;
+      pages.insert(pages.begin(), base - new_base, nullptr);
+      occupied.insert(occupied.begin(), (base - new_base) / 64, 0);
+      leading_words += (base - new_base) / 64;
+      base = new_base;
+    }
+    size_t i = number - base;
+    if (i >= pages.size()) {
+      pages.resize(i + 1, nullptr);
+      occupied.resize(pages.size() / 64 + 1, 0);
+    }
+    Page*& p = pages[i];
+    if (p == nullptr) {
+      p = new Page(this, number);
+      occupied[i / 64] |= uint64_t(1) << (i % 64);
+      leading_words = std::min(leading_words, i / 64);
+      ++page_count;
+    }
+    size_t r = p->rank(offset);
+    if (p->test(offset)) {
+      p->entries[r].v = v;
+      return;
+    }
+    p->bits[offset / 64] |= uint64_t(1) << (offset % 64);
+    p->entries.insert(p->entries.begin() + r, Node(k, v, p));
+    ++size;
+  }
+
+  void remove_precise(const K& k) {
+    Node* ptr = find_precise_node(k);
+    if (ptr != nullptr) {
+      remove(ptr);
+    }
+  }
+
+  void remove_le(const K& k) {
+    Node* ptr = find_le_node(k);
+    if (ptr != nullptr) {
+      remove(ptr);
+    }
+  }
+
+  void remove(Node* ptr) {
+    Page* p = ptr->page;
+    size_t offset = index_of(ptr->k) % page_size;
+    // destroyed only once the index is consistent again, as its destructor may look at the index.
+    V removed = std::move(ptr->v);
+    p->bits[offset / 64] &= ~(uint64_t(1) << (offset % 64));
+    p->entries.erase(p->entries.begin() + ptr->idx());
+    --size;
+    if (p->entries.empty()) {
+      size_t i = p->number - base;
+      pages[i] = nullptr;
+      occupied[i / 64] &= ~(uint64_t(1) << (i % 64));
+      --page_count;
+      delete p;
+      if (occupied[i / 64] == 0) {
+        shrink_directory();
+      }
+    }
+  }
+
+  // drop the empty words at the back, and rebase past those at the front once they are 3/4 of the directory,
+  // so a key removed and inserted again at the front does not move the whole directory every time.
+  void shrink_directory() {
+    while (leading_words < occupied.size() && occupied[leading_words] == 0) {
+      ++leading_words;
+    }
+    while (!occupied.empty() && occupied.back() == 0) {
+      occupied.pop_back();
+    }
+    if (occupied.empty()) {
+      std::vector<Page*>().swap(pages);
+      std::vector<uint64_t>().swap(occupied);
+      base = 0;
+      leading_words = 0;
+      return;
+    }
+    pages.resize(std::min(pages.size(), occupied.size() * 64));
+    if (leading_words * 4 > occupied.size() * 3) {
+      pages.erase(pages.begin(), pages.begin() + leading_words * 64);
+      occupied.erase(occupied.begin(), occupied.begin() + leading_words);
+      pages.shrink_to_fit();
+      occupied.shrink_to_fit();
+      base += leading_words * 64;
+      leading_words = 0;
+    }
+  }
+};
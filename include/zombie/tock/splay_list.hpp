@@ -8,8 +8,10 @@
 #include <memory>
 
 #include "common.hpp"
+#include "../pool.hpp"
 
-template<typename K, typename V>
+// with [pooled], nodes come from a SlabPool owned by the list instead of one new/delete each.
+template<typename K, typename V, bool pooled = false>
 struct SplayList {
   struct Node {
     K k;
@@ -35,6 +37,10 @@ struct SplayList {
       }
     }
 
+    // the neighbouring nodes in key order.
+    Node* prev() const { return parent; }
+    Node* next() const { return children; }
+
     size_t idx_at_parent() const {
       assert(splay_parent != nullptr);
       return splay_parent->splay_children[0] == this ? 0 : 1;
@@ -94,7 +100,7 @@ struct SplayList {
         tl.root_node = std::move(splay_children[1]);
       }
 
-      delete this;
+      tl.delete_node(this);
     }
 
     void rotate(Node*& root_node) {
@@ -127,9 +133,28 @@ struct SplayList {
     }
 
   };
+  SlabPool node_pool = SlabPool(sizeof(Node));
   mutable Node* root_node = nullptr;
   size_t size = 0;
 
+  template<typename... Args>
+  Node* new_node(Args&&... args) {
+    if constexpr (pooled) {
+      return new (node_pool.allocate()) Node(std::forward<Args>(args)...);
+    } else {
+      return new Node(std::forward<Args>(args)...);
+    }
+  }
+
+  void delete_node(Node* n) {
+    if constexpr (pooled) {
+      n->~Node();
+      node_pool.deallocate(n);
+    } else {
+      delete n;
+    }
+  }
+
   ~SplayList() {
     Node* root_node_copy = root_node;
     root_node = nullptr;
@@ -138,17 +163,21 @@ struct SplayList {
       for (Node* left_ptr = root_node_copy->parent; left_ptr != nullptr;) {
         Node* to_delete = left_ptr;
         left_ptr = left_ptr->parent;
-        delete to_delete;
+        delete_node(to_delete);
       }
       for (Node* right_ptr = root_node_copy->children; right_ptr != nullptr;) {
         Node* to_delete = right_ptr;
         right_ptr = right_ptr->children;
-        delete to_delete;
+        delete_node(to_delete);
       }
-      delete root_node;
+      delete_node(root_node_copy);
     }
   }
 
+  size_t memory_bytes() const {
+    return size * sizeof(Node);
+  }
+
   // for insert
   // you have to insert the new node at the leaf before splay
   Node* find_node_without_splay(const K& k) {
@@ -227,29 +256,33 @@ struct SplayList {
   void remove_le(const K& k) {
     Node* ptr = find_le_node(k);
     if (ptr != nullptr) {
-      ptr->remove(*this);
-      --size;
+      remove(ptr);
     }
   }
 
   void remove_precise(const K& k) {
     Node* ptr = find_precise_node(k);
     if (ptr != nullptr) {
-      ptr->remove(*this);
-      --size;
+      remove(ptr);
     }
   }
 
+  // remove a node already found, without searching for it again.
+  void remove(Node* ptr) {
+    ptr->remove(*this);
+    --size;
+  }
+
   void insert(const K& k, const V& v) {
     Node* ptr = find_node_without_splay(k);
     if (ptr != nullptr) {
       if (ptr->k < k) {
         assert(ptr->splay_children[1] == nullptr);
-        ptr->splay_children[1] = new Node(k, v, ptr, ptr->children, ptr);
+        ptr->splay_children[1] = new_node(k, v, ptr, ptr->children, ptr);
         ++size;
       } else if (k < ptr->k) {
         assert(ptr->splay_children[0] == nullptr);
-        ptr->splay_children[0] = new Node(k, v, ptr->parent, ptr, ptr);
+        ptr->splay_children[0] = new_node(k, v, ptr->parent, ptr, ptr);
         ++size;
       } else {
         assert (ptr->k == k);
@@ -257,7 +290,7 @@ struct SplayList {
       }
       ptr->splay(this->root_node);
     } else {
-      root_node = new Node(k, v, nullptr, nullptr, nullptr);
+      root_node = new_node(k, v, nullptr, nullptr, nullptr);
       ++size;
     }
   }
@@ -5,3 +5,5 @@
 #include "../config.hpp"
 #include "common.hpp"
 #include "splay_list.hpp"
+#include "btree_list.hpp"
+#include "page_list.hpp"
@@ -0,0 +1,424 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+
+// Tracing with compile time levels.
+// A trace point above ZOMBIE_TRACE_LEVEL compile to nothing, arguments included.
+// Enabled trace points write a fixed size binary TraceEvent into a per thread ring buffer,
+// which is lock free (single producer: the owning thread, single consumer: whoever drain).
+// Nothing is ever written out implicitly: call Trace::drain or Trace::dump.
+//
+// ZOMBIE_TRACE_LEVEL must be the same in every translation unit of a program.
+#ifndef ZOMBIE_TRACE_LEVEL
+#define ZOMBIE_TRACE_LEVEL 0
+#endif
+
+enum class TraceLevel : int {
+  Off = 0,
+  // coarse grained runtime events: contexts, replays, evictions.
+  Info = 1,
+  // per operation events inside the data structures.
+  Debug = 2
+};
+
+constexpr bool trace_enabled(TraceLevel level) {
+  return static_cast<int>(level) <= ZOMBIE_TRACE_LEVEL;
+}
+
+// the meaning of TraceEvent::a, b, c is given for each kind.
+enum class TraceKind : uint8_t {
+  // context start tock, time taken, akasha size
+  InsertContext,
+  // context start tock, cost, book size
+  Evict,
+  // context start tock, forward_at, replay depth
+  ReplayBegin,
+  // context start tock, 0, replay depth
+  ReplayEnd,
+  // largest uf value, uf root count, uf node count
+  LargestUF,
+  // current tock, 0, 0
+  CurrentTockChange,
+  // UFSet size, 0, 0
+  UFSetInsert,
+  // popped cost, popped L, heap size
+  HeapPop,
+  // waiting size, heap size, 0
+  HeapReadjust,
+  // value created tock, resident bytes after the change, signed size of the change
+  Resident,
+};
+
+// whether TraceEvent::a is a tock, which the binary format delta encode.
+constexpr bool trace_kind_has_tock(TraceKind kind) {
+  switch (kind) {
+  case TraceKind::InsertContext:
+  case TraceKind::Evict:
+  case TraceKind::ReplayBegin:
+  case TraceKind::ReplayEnd:
+  case TraceKind::CurrentTockChange:
+  case TraceKind::Resident:
+    return true;
+  default:
+    return false;
+  }
+}
+
+inline const char* trace_kind_name(TraceKind kind) {
+  switch (kind) {
+  case TraceKind::InsertContext: return "insert_context";
+  case TraceKind::Evict: return "evict";
+  case TraceKind::ReplayBegin: return "replay_begin";
+  case TraceKind::ReplayEnd: return "replay_end";
+  case TraceKind::LargestUF: return "largest_uf";
+  case TraceKind::CurrentTockChange: return "current_tock_change";
+  case TraceKind::UFSetInsert: return "ufset_insert";
+  case TraceKind::HeapPop: return "heap_pop";
+  case TraceKind::HeapReadjust: return "heap_readjust";
+  case TraceKind::Resident: return "resident";
+  }
+  return "unknown";
+}
+
+struct TraceEvent {
+  int64_t timestamp;
+  int64_t a, b, c;
+  TraceKind kind;
+};
+
+// Single producer single consumer. When full, new events are dropped and counted.
+struct TraceRing {
+  static constexpr size_t capacity = 1 << 14;
+  static_assert((capacity & (capacity - 1)) == 0);
+
+  // identify the thread in the binary format. wrap around after 2^16 threads.
+  uint16_t thread = 0;
+
+  std::array<TraceEvent, capacity> events;
+  std::atomic<size_t> head = 0; // next to read, written by consumer
+  std::atomic<size_t> tail = 0; // next to write, written by producer
+  std::atomic<size_t> dropped = 0;
+
+  void push(const TraceEvent& e) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == capacity) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      events[t % capacity] = e;
+      tail.store(t + 1, std::memory_order_release);
+    }
+  }
+
+  template<typename F>
+  size_t drain(const F& f) {
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_acquire);
+    for (size_t i = h; i < t; ++i) {
+      f(events[i % capacity]);
+    }
+    head.store(t, std::memory_order_release);
+    return t - h;
+  }
+};
+
+struct Trace {
+  // every live thread's ring, so one thread can drain them all.
+  struct Registry {
+    std::mutex mutex;
+    std::vector<TraceRing*> rings;
+    uint16_t next_thread = 0;
+  };
+
+  static Registry& registry() {
+    // leaked on purpose: threads may still unregister during static destruction.
+    static Registry* r = new Registry();
+    return *r;
+  }
+
+  struct ThreadRing {
+    TraceRing ring;
+    ThreadRing() {
+      Registry& r = registry();
+      std::lock_guard<std::mutex> guard(r.mutex);
+      ring.thread = r.next_thread++;
+      r.rings.push_back(&ring);
+    }
+    // events not drained by the time the thread exit are lost.
+    ~ThreadRing() {
+      ring_gone() = true;
+      Registry& r = registry();
+      std::lock_guard<std::mutex> guard(r.mutex);
+      r.rings.erase(std::find(r.rings.begin(), r.rings.end(), &ring));
+    }
+  };
+
+  static TraceRing& ring() {
+    thread_local ThreadRing tr;
+    return tr.ring;
+  }
+
+  // set once the thread's ring is destroyed: runtimes torn down after it (e.g. static ones) emit nothing.
+  static bool& ring_gone() {
+    thread_local bool gone = false;
+    return gone;
+  }
+
+  static void emit(TraceKind kind, int64_t a = 0, int64_t b = 0, int64_t c = 0) {
+    if (ring_gone()) {
+      return;
+    }
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    ring().push(TraceEvent{now, a, b, c, kind});
+  }
+
+  // drain every thread's ring into f, return the number of events.
+  // events of a single thread come in order, but threads are not interleaved by time.
+  template<typename F>
+  static size_t drain(const F& f) {
+    return drain_threads([&](uint16_t, const TraceEvent& e) { f(e); });
+  }
+
+  // same as drain, but f also take the id of the emitting thread.
+  template<typename F>
+  static size_t drain_threads(const F& f) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    size_t ret = 0;
+    for (TraceRing* ring : r.rings) {
+      ret += ring->drain([&](const TraceEvent& e) { f(ring->thread, e); });
+    }
+    return ret;
+  }
+
+  static size_t dropped() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    size_t ret = 0;
+    for (TraceRing* ring : r.rings) {
+      ret += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return ret;
+  }
+
+  // drain as human readable text, one event per line.
+  static size_t dump(std::ostream& os) {
+    return drain([&](const TraceEvent& e) {
+      os << e.timestamp << " " << trace_kind_name(e.kind) << " " << e.a << " " << e.b << " " << e.c << "\n";
+    });
+  }
+};
+
+// The binary trace format.
+//
+// header: the magic "ZTRC", then uint32 version, uint32 record size.
+// body: a sequence of fixed size records, all integers little endian:
+//   uint8 kind, uint8 reserved, uint16 thread, uint32 dt, int32 a, int64 b, int64 c.
+// dt is the timestamp minus the timestamp of the previous record of the same thread,
+// and for kinds with trace_kind_has_tock, a is the tock minus the previous tock of the thread.
+// A Rebase record (kind 255) set both bases of a thread to absolute values (b: timestamp, c: tock).
+// It is written before the first record of a thread, and whenever dt or the tock delta does not fit.
+// A Wide record (kind 254) carry in b the a of the next record of it's thread, when it does not fit in 32 bits.
+namespace TraceFormat {
+  constexpr char magic[4] = {'Z', 'T', 'R', 'C'};
+  constexpr uint32_t version = 2;
+  constexpr uint32_t record_size = 28;
+  constexpr uint8_t rebase = 255;
+  constexpr uint8_t wide = 254;
+
+  struct Record {
+    uint8_t kind;
+    uint16_t thread;
+    uint32_t dt;
+    int32_t a;
+    int64_t b, c;
+  };
+
+  inline bool fit_a(int64_t a) {
+    return a >= std::numeric_limits<int32_t>::min() && a <= std::numeric_limits<int32_t>::max();
+  }
+
+  struct Base {
+    int64_t timestamp;
+    int64_t tock;
+    // the a of the next record, from a Wide record.
+    std::optional<int64_t> wide;
+  };
+
+  inline void put(char*& out, uint64_t x, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+      *out++ = static_cast<char>((x >> (8 * i)) & 0xff);
+    }
+  }
+
+  inline uint64_t get(const char*& in, size_t bytes) {
+    uint64_t ret = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+      ret |= static_cast<uint64_t>(static_cast<uint8_t>(*in++)) << (8 * i);
+    }
+    return ret;
+  }
+
+  inline void write_record(std::ostream& os, const Record& r) {
+    char buf[record_size];
+    char* out = buf;
+    put(out, r.kind, 1);
+    put(out, 0, 1);
+    put(out, r.thread, 2);
+    put(out, r.dt, 4);
+    put(out, static_cast<uint32_t>(r.a), 4);
+    put(out, r.b, 8);
+    put(out, r.c, 8);
+    os.write(buf, record_size);
+  }
+
+  inline bool read_record(std::istream& is, Record& r) {
+    char buf[record_size];
+    if (!is.read(buf, record_size)) {
+      return false;
+    }
+    const char* in = buf;
+    r.kind = get(in, 1);
+    get(in, 1);
+    r.thread = get(in, 2);
+    r.dt = get(in, 4);
+    r.a = static_cast<int32_t>(get(in, 4));
+    r.b = get(in, 8);
+    r.c = get(in, 8);
+    return true;
+  }
+}
+
+// Write the binary trace format. The header is written on construction,
+// each flush then append every event emitted since the previous flush.
+struct TraceWriter {
+  std::ostream& os;
+  std::unordered_map<uint16_t, TraceFormat::Base> bases;
+
+  explicit TraceWriter(std::ostream& os) : os(os) {
+    char buf[12];
+    char* out = buf;
+    std::copy(TraceFormat::magic, TraceFormat::magic + 4, out);
+    out += 4;
+    TraceFormat::put(out, TraceFormat::version, 4);
+    TraceFormat::put(out, TraceFormat::record_size, 4);
+    os.write(buf, sizeof(buf));
+  }
+
+  void write(uint16_t thread, const TraceEvent& e) {
+    auto it = bases.find(thread);
+    int64_t dt = it == bases.end() ? -1 : e.timestamp - it->second.timestamp;
+    bool has_tock = trace_kind_has_tock(e.kind);
+    if (dt < 0 || dt > std::numeric_limits<uint32_t>::max() ||
+        (has_tock && !TraceFormat::fit_a(e.a - it->second.tock))) {
+      TraceFormat::write_record(os, {TraceFormat::rebase, thread, 0, 0, e.timestamp, e.a});
+      it = bases.insert_or_assign(thread, TraceFormat::Base{e.timestamp, e.a}).first;
+      dt = 0;
+    }
+    TraceFormat::Base& base = it->second;
+    int64_t a = e.a;
+    if (has_tock) {
+      a -= base.tock;
+      base.tock = e.a;
+    } else if (!TraceFormat::fit_a(a)) {
+      TraceFormat::write_record(os, {TraceFormat::wide, thread, 0, 0, a, 0});
+      a = 0;
+    }
+    base.timestamp = e.timestamp;
+    TraceFormat::write_record(os, {static_cast<uint8_t>(e.kind), thread, static_cast<uint32_t>(dt), static_cast<int32_t>(a), e.b, e.c});
+  }
+
+  size_t flush() {
+    size_t ret = Trace::drain_threads([&](uint16_t thread, const TraceEvent& e) { write(thread, e); });
+    os.flush();
+    return ret;
+  }
+};
+
+// Read the binary trace format back into TraceEvent.
+struct TraceReader {
+  std::istream& is;
+  uint32_t version = 0;
+  std::unordered_map<uint16_t, TraceFormat::Base> bases;
+
+  // throw std::runtime_error if the header is not a supported trace.
+  explicit TraceReader(std::istream& is) : is(is) {
+    char buf[12];
+    if (!is.read(buf, sizeof(buf)) || !std::equal(buf, buf + 4, TraceFormat::magic)) {
+      throw std::runtime_error("not a zombie trace");
+    }
+    const char* in = buf + 4;
+    version = TraceFormat::get(in, 4);
+    uint32_t record_size = TraceFormat::get(in, 4);
+    if (version != TraceFormat::version || record_size != TraceFormat::record_size) {
+      throw std::runtime_error("unsupported zombie trace version " + std::to_string(version));
+    }
+  }
+
+  // read the next event, return false at the end of the trace.
+  bool next(uint16_t& thread, TraceEvent& e) {
+    TraceFormat::Record r;
+    while (TraceFormat::read_record(is, r)) {
+      if (r.kind == TraceFormat::rebase) {
+        bases[r.thread] = TraceFormat::Base{r.b, r.c, std::nullopt};
+        continue;
+      }
+      auto it = bases.find(r.thread);
+      if (it == bases.end()) {
+        throw std::runtime_error("zombie trace record before rebase");
+      }
+      TraceFormat::Base& base = it->second;
+      if (r.kind == TraceFormat::wide) {
+        base.wide = r.b;
+        continue;
+      }
+      base.timestamp += r.dt;
+      thread = r.thread;
+      e.timestamp = base.timestamp;
+      e.kind = static_cast<TraceKind>(r.kind);
+      e.a = r.a;
+      if (trace_kind_has_tock(e.kind)) {
+        e.a += base.tock;
+        base.tock = e.a;
+      } else if (base.wide) {
+        e.a = *base.wide;
+        base.wide.reset();
+      }
+      e.b = r.b;
+      e.c = r.c;
+      return true;
+    }
+    return false;
+  }
+
+  template<typename F>
+  size_t for_each(const F& f) {
+    size_t ret = 0;
+    uint16_t thread;
+    TraceEvent e;
+    while (next(thread, e)) {
+      f(thread, e);
+      ++ret;
+    }
+    return ret;
+  }
+};
+
+#define ZOMBIE_TRACE(level, ...)                                                                   \
+  do {                                                                                             \
+    if constexpr (trace_enabled(level)) {                                                          \
+      Trace::emit(__VA_ARGS__);                                                                    \
+    }                                                                                              \
+  } while (false)
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <algorithm>
 #include <unordered_set>
 #include <fstream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #include "context.hpp"
 #include "base.hpp"
@@ -10,8 +14,13 @@
 #include "meter.hpp"
 #include "config.hpp"
 #include "zombie_types.hpp"
+#include "heap/b_heap.hpp"
+#include "heap/d_heap.hpp"
 #include "heap/gd_heap.hpp"
+#include "heap/sampled_book.hpp"
 #include "uf.hpp"
+#include "stats.hpp"
+#include "pool.hpp"
 
 namespace ZombieInternal {
 
@@ -29,6 +38,15 @@ struct RecomputeLater : Phantom {
       ptr->pool_index = idx;
     }
   }
+  void notify_removed() override {
+    if (auto ptr = weak_ptr.lock()) {
+      ptr->pool_index = -1;
+    }
+  }
+  bool dead() const override {
+    return weak_ptr.expired();
+  }
+  bool pinned() const override;
 };
 
 template<const ZombieConfig& cfg>
@@ -47,30 +65,210 @@ public:
   };
 
   struct NotifyElementRemoved {
-    void operator()(const std::unique_ptr<Phantom>& p) { }
+    void operator()(const std::unique_ptr<Phantom>& p) {
+      p->notify_removed();
+    }
   };
 
   struct Reaper;
+  struct Reclaimer;
+
+  // returned by lock() when the runtime is not shared.
+  struct NoLock { };
+
+  // A hit on a resident value does not touch the eviction heap right away.
+  // Instead, the accessed tock is queued in a per thread buffer, back to back hits on the same value folding into one entry,
+  // and replayed into the eviction heap when the buffer fill up, and before every eviction decision.
+  // In RuntimeMode::Shared, hits do not take the runtime lock either: the buffer is replayed once this thread next hold the lock.
+  // When the buffer fill up while the lock is contended, it is dropped:
+  // access recency is a hint for eviction, not a correctness matter.
+  struct AccessBuffer {
+    static constexpr size_t capacity = 64;
+    struct Access {
+      Tock tock;
+      // resolved on record, outside of RuntimeMode::Shared.
+      // a context destroyed before the replay, e.g. replaced in akasha by a replay of itself, null it's entries out (~ContextNode),
+      // and they are looked up in akasha on replay, like every entry in RuntimeMode::Shared, where another thread might evict it.
+      ContextNode<cfg>* context;
+      // hits folded into this entry.
+      size_t count;
+      // of the last of them, only kept when the policy look at it (see track_access_time).
+      ns time;
+    };
+    std::vector<Access> accesses;
+    // lock free hits, added to Counters::hits on drain.
+    size_t hits = 0;
+    AccessBuffer() {
+      accesses.reserve(capacity);
+    }
+  };
+  // LRU rank by the time of the access, not the time it is replayed.
+  static constexpr bool track_access_time = cfg.eviction_policy == EvictionPolicy::LRU;
+
+  // plain counters for ZombieStats, only touched with the runtime lock held.
+  struct Counters {
+    size_t hits = 0;
+    size_t rematerializations = 0;
+    size_t replays = 0;
+    size_t max_replay_depth = 0;
+    size_t evictions = 0;
+    size_t cost_evaluations = 0;
+    size_t cost_memo_hits = 0;
+    size_t book_entries_removed = 0;
+  };
+  // in RuntimeMode::Shared a value may be released by any thread, outside of the lock.
+  using counter_t = std::conditional_t<cfg.runtime == RuntimeMode::Shared, std::atomic<size_t>, size_t>;
+  static constexpr bool pool_contexts = cfg.pool_allocation && cfg.runtime != RuntimeMode::Shared;
 public:
+  // contexts are allocated from it when pool_contexts.
+  // declared first, so it is released after everything else.
+  SlabArena* arena = new SlabArena();
+  // every UF of the contexts, which outlive them.
+  UFArena<Time> uf_arena;
+  std::recursive_mutex mutex;
+  // bytes held by live values, maintained by ZombieNode.
+  // declared before akasha and records, so it outlive the values they hold.
+  counter_t resident_bytes = 0;
+  counter_t resident_values = 0;
+  // bytes held by contexts, maintained by ContextNode.
+  counter_t context_bytes = 0;
+  // the AccessBuffer, outside of RuntimeMode::Shared, where a single thread use the runtime.
+  // a member so the contexts destroyed with it can still reach it.
+  AccessBuffer accesses;
   Tock current_tock = 1;
-  SplayList<Tock, Context<cfg>> akasha;
-  GDHeap<cfg, std::unique_ptr<Phantom>, NotifyIndexChanged, NotifyElementRemoved> book;
+  using Akasha = std::conditional_t<cfg.akasha == AkashaIndex::BTree,
+                                    BTreeList<Tock, Context<cfg>>,
+                                    std::conditional_t<cfg.akasha == AkashaIndex::PageTable,
+                                                       PageList<Tock, Context<cfg>>,
+                                                       SplayList<Tock, Context<cfg>, cfg.pool_allocation>>>;
+  Akasha akasha;
+  using Book = std::conditional_t<cfg.book_heap == BookHeap::Sampled,
+                                  SampledBook<cfg, std::unique_ptr<Phantom>, NotifyIndexChanged, NotifyElementRemoved>,
+                                  GDHeap<cfg, std::unique_ptr<Phantom>, NotifyIndexChanged, NotifyElementRemoved>>;
+  Book book;
   std::vector<Record<cfg>> records = {std::make_shared<RootRecordNode<cfg>>(Tock(0))};
   std::vector<Replay<cfg>> replays = {Replay<cfg>{}};
-  ZombieMeter meter;
+  // RuntimeMode::ThreadLocal only: each runtime keep it's own time, so fast forwarding one does not leak into the others.
+  ZombieClock clock;
+  ZombieMeter meter = ZombieMeter(cfg.runtime == RuntimeMode::ThreadLocal ? clock : ZombieClock::singleton());
   Reaper reaper = Reaper(*this);
+  Reclaimer reclaimer = Reclaimer(*this);
   std::function<void()> each_step = [](){};
   Time recompute_time = Time(0);
+  Counters counters;
+
+  // values an executing RecomputePlan still need, by created_time, once per pin.
+  // pinned before they come back, so the context bringing them back is pinned as soon as it is in the book.
+  std::vector<Tock> pinned_tocks;
+
+  // whether [ctx] hold a pinned value, which the reaper pass over.
+  bool pinned(const ContextNode<cfg>& ctx) const {
+    return std::any_of(pinned_tocks.begin(), pinned_tocks.end(),
+                       [&](const Tock& t) { return ctx.start_t < t && t < ctx.end_t; });
+  }
+
+  // put back an entry taken out of the book without evicting it's context.
+  void repush(std::unique_ptr<Phantom>&& p) {
+    if (auto ctx = static_cast<RecomputeLater<cfg>*>(p.get())->weak_ptr.lock()) {
+      ctx->pool_index = FullContextNode<cfg>::waiting_index;
+      cost_t cost = ctx->policy_cost();
+      book.push(std::move(p), cost);
+    }
+  }
 
 public:
   Trailokya() { }
-  ~Trailokya() { }
+  ~Trailokya() {
+    reclaimer.stop_thread();
+    // the contexts, destroyed after the book, would take their entry out of it.
+    book.clear();
+    // freed once the contexts, destroyed after this body, are gone.
+    arena->release();
+  }
+
+  template<typename T, typename... Args>
+  std::shared_ptr<T> make_context(Args&&... args) {
+    if constexpr (pool_contexts) {
+      return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+    } else {
+      return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+  }
+
+  // called between steps of execution, i.e. between bindZombie and between replayed records.
+  void step() {
+    reclaimer.step();
+    each_step();
+  }
 
   static Trailokya& get_trailokya() {
-    static Trailokya t;
-    return t;
+    if constexpr (cfg.runtime == RuntimeMode::ThreadLocal) {
+      thread_local Trailokya t;
+      return t;
+    } else {
+      static Trailokya t;
+      return t;
+    }
   }
 
+  // Serialize access to the runtime. A no-op unless the runtime is shared.
+  // The mutex is recursive, as user code running inside bindZombie re-enter the runtime.
+  auto lock() {
+    if constexpr (cfg.runtime == RuntimeMode::Shared) {
+      std::unique_lock<std::recursive_mutex> guard(mutex);
+      drain_access_buffer();
+      return guard;
+    } else {
+      return NoLock();
+    }
+  }
+
+  static AccessBuffer& access_buffer() {
+    if constexpr (cfg.runtime == RuntimeMode::Shared) {
+      thread_local AccessBuffer buffer;
+      return buffer;
+    } else {
+      return get_trailokya().accesses;
+    }
+  }
+
+  // lock free. [get_context] is only called outside of RuntimeMode::Shared.
+  template<typename F>
+  void record_access(const Tock& tock, const F& get_context) {
+    AccessBuffer& buffer = access_buffer();
+    ns time = track_access_time ? meter.raw_time() : ns(0);
+    if (!buffer.accesses.empty() && buffer.accesses.back().tock == tock) {
+      ++buffer.accesses.back().count;
+      buffer.accesses.back().time = time;
+      return;
+    }
+    ContextNode<cfg>* context = nullptr;
+    if constexpr (cfg.runtime != RuntimeMode::Shared) {
+      context = get_context();
+      if (context == nullptr) {
+        return;
+      }
+    }
+    buffer.accesses.push_back(typename AccessBuffer::Access{tock, context, 1, time});
+    if (buffer.accesses.size() >= AccessBuffer::capacity) {
+      if constexpr (cfg.runtime == RuntimeMode::Shared) {
+        std::unique_lock<std::recursive_mutex> guard(mutex, std::try_to_lock);
+        if (guard.owns_lock()) {
+          drain_access_buffer();
+        } else {
+          buffer.accesses.clear();
+        }
+      } else {
+        drain_access_buffer();
+      }
+    }
+  }
+
+  // must hold the lock.
+  void drain_access_buffer();
+
+  ZombieStats stats();
+
 public:
   struct Reaper {
     Trailokya& t;
@@ -78,18 +276,177 @@ public:
     Reaper(Trailokya& t) : t(t) { }
 
     bool have_soul() {
+      auto guard = t.lock();
       return t.book.empty();
     }
 
-    void murder() {
+    // evict the cheapest context.
+    // return false, evicting nothing, when every context left is pinned by an executing RecomputePlan.
+    bool murder() {
+      auto guard = t.lock();
+      t.drain_access_buffer();
       assert (t.book.size() > 0);
-      t.book.adjust_pop([](const std::unique_ptr<Phantom>& p) { return p->cost(); })->evict();
+      return evict_one();
+    }
+
+    // evict the cheapest context that is not pinned.
+    // the pinned ones popped on the way are pushed back, without moving L, once a victim is found.
+    // return false when every context left is pinned.
+    bool evict_one() {
+      auto cost_f = [](const std::unique_ptr<Phantom>& p) { return p->cost(); };
+      if (t.pinned_tocks.empty()) {
+        t.book.adjust_pop(cost_f)->evict();
+        return true;
+      }
+      std::vector<std::unique_ptr<Phantom>> passed;
+      bool evicted = false;
+      while (!t.book.empty()) {
+        cost_t L = t.book.L;
+        std::unique_ptr<Phantom> p = t.book.adjust_pop(cost_f);
+        if (p->pinned()) {
+          t.book.L = L;
+          passed.push_back(std::move(p));
+        } else {
+          p->evict();
+          evicted = true;
+          break;
+        }
+      }
+      for (auto& p : passed) {
+        t.repush(std::move(p));
+      }
+      return evicted;
+    }
+
+    // evict until resident bytes fit in the budget, or nothing is left to evict.
+    void enforce_budget() {
+      t.reclaimer.allocated();
+      if constexpr (cfg.memory_budget != 0) {
+        auto guard = t.lock();
+        if (t.resident_bytes > cfg.memory_budget && !t.book.empty()) {
+          ++t.reclaimer.foreground_stalls;
+          t.reclaimer.foreground_evictions += evict_while([&]() { return t.resident_bytes > cfg.memory_budget; });
+        }
+      }
+    }
+
+    // evict while [more]() hold and something is left to evict, under a single lock.
+    // the victims are still chosen one at a time, exactly as a murder() loop would, as each eviction change the cost of it's neighbours.
+    // return how many contexts were evicted.
+    template<typename F>
+    size_t evict_while(const F& more) {
+      auto guard = t.lock();
+      t.drain_access_buffer();
+      size_t evicted = 0;
+      while (more() && !t.book.empty() && evict_one()) {
+        ++evicted;
+      }
+      return evicted;
+    }
+
+    // evict until resident bytes is at most [bytes], at most [batch] contexts at a time.
+    // return whether the target is reached, or nothing is left to evict (the book is empty, or all pinned).
+    bool evict_down_to(size_t bytes, size_t batch) {
+      auto guard = t.lock();
+      size_t evicted = 0;
+      size_t ret = evict_while([&]() { return evicted++ < batch && t.resident_bytes > bytes; });
+      t.reclaimer.background_evictions += ret;
+      return t.resident_bytes <= bytes || t.book.empty() || ret == 0;
     }
 
     uint64_t score() {
+      auto guard = t.lock();
       return t.book.score();
     }
   };
+
+  // Evict ahead of time with a high and a low watermark (see ZombieConfig::watermarks),
+  // so the allocating path seldom need to evict.
+  // Normally it run synchronously between steps.
+  // In RuntimeMode::Shared it run on a dedicated thread, started on first need,
+  // which take the runtime lock one batch at a time.
+  struct Reclaimer {
+    static constexpr bool enabled = cfg.watermarks.first != 0;
+    static constexpr bool threaded = enabled && cfg.runtime == RuntimeMode::Shared;
+    static_assert(cfg.watermarks.second <= cfg.watermarks.first, "low watermark must not be above high watermark");
+
+    Trailokya& t;
+
+    // times the reclaimer found usage above the high watermark.
+    // like the other counters, only touched with the runtime lock held, as the reclaimer thread update them.
+    size_t background_runs = 0;
+    size_t background_evictions = 0;
+    // times the allocating path still had to evict to respect the budget.
+    size_t foreground_stalls = 0;
+    size_t foreground_evictions = 0;
+
+    std::thread thread;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    bool pending = false;
+    bool stopping = false;
+
+    Reclaimer(Trailokya& t) : t(t) { }
+
+    bool above_high() const {
+      return t.resident_bytes > cfg.watermarks.first;
+    }
+
+    void reclaim() {
+      {
+        auto guard = t.lock();
+        ++background_runs;
+      }
+      while (!t.reaper.evict_down_to(cfg.watermarks.second, cfg.reclaim_batch)) { }
+    }
+
+    void step() {
+      if constexpr (enabled && !threaded) {
+        if (above_high()) {
+          reclaim();
+        }
+      }
+    }
+
+    // called after a value is constructed.
+    void allocated() {
+      if constexpr (threaded) {
+        if (above_high()) {
+          std::lock_guard<std::mutex> guard(wake_mutex);
+          if (!thread.joinable() && !stopping) {
+            thread = std::thread([this]() { run(); });
+          }
+          pending = true;
+          wake.notify_one();
+        }
+      }
+    }
+
+    void run() {
+      std::unique_lock<std::mutex> guard(wake_mutex);
+      while (true) {
+        wake.wait(guard, [&]() { return pending || stopping; });
+        if (stopping) {
+          return;
+        }
+        pending = false;
+        guard.unlock();
+        reclaim();
+        guard.lock();
+      }
+    }
+
+    void stop_thread() {
+      {
+        std::lock_guard<std::mutex> guard(wake_mutex);
+        stopping = true;
+        wake.notify_one();
+      }
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  };
 };
 
 } // end of namespace ZombieInternal
@@ -4,127 +4,221 @@
 #include <vector>
 #include <random>
 #include <unordered_set>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
 
-#include <nlohmann/json.hpp>
+#include "common.hpp"
 
+// The nodes of every UF sharing an arena, as parallel arrays indexed by 32 bit slot.
+// A slot is refcounted, by the UF pointing at it and by the slots whose parent it is,
+// and is reused once nothing point at it anymore.
+// Not thread safe: an arena is used by one thread at a time, see ThreadLocalUFArena.
 template<typename T>
-struct UFNode : std::enable_shared_from_this<UFNode<T>> {
-  static int& get_uf_root_count() {
-    static int uf_root_count = 0;
-    return uf_root_count;
-  }
+struct UFArena {
+  static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+  static constexpr size_t slot_bytes = 4 * sizeof(uint32_t) + sizeof(T) + sizeof(uint64_t);
 
-  static int& get_uf_node_count() {
-    static int uf_node_count = 0;
-    return uf_node_count;
-  }
+  // parent[i] == i for a root.
+  std::vector<uint32_t> parent;
+  // only meaningful for a root.
+  std::vector<uint32_t> size;
+  std::vector<uint32_t> refs;
+  // only meaningful for a root.
+  std::vector<T> value;
+  // bumped whenever value change, so a memoized sum (see UFMemo) can tell it is stale.
+  // only meaningful for a root.
+  std::vector<uint64_t> version;
+  // the last generation a root was counted in, see UFCounted.
+  std::vector<uint32_t> stamp;
+  std::vector<uint32_t> free_slots;
 
-  static T& get_largest() {
-    static T largest(0);
-    return largest;
-  }
+  uint32_t generation = 0;
+  // the roots counted in the current generation.
+  std::vector<uint32_t> counted;
 
-  // parent < shared_from_this()
-  mutable std::shared_ptr<UFNode> parent;
+  size_t root_count = 0;
+  T largest = T(0);
 
-  T t; // only meaningful when parent.get() == nullptr
+  size_t node_count() const {
+    return parent.size() - free_slots.size();
+  }
 
-  std::shared_ptr<UFNode> get_root() {
-    if (parent == nullptr) {
-      return this->shared_from_this();
+  uint32_t make(const T& t) {
+    uint32_t i;
+    if (!free_slots.empty()) {
+      i = free_slots.back();
+      free_slots.pop_back();
+      parent[i] = i;
+      size[i] = 1;
+      refs[i] = 1;
+      value[i] = t;
+      version[i] = 0;
+      stamp[i] = 0;
     } else {
-      parent = parent->get_root();
-      assert(parent->parent == nullptr);
-      return parent;
+      assert(parent.size() < none);
+      i = parent.size();
+      parent.push_back(i);
+      size.push_back(1);
+      refs.push_back(1);
+      value.push_back(t);
+      version.push_back(0);
+      stamp.push_back(0);
     }
+    ++root_count;
+    return i;
   }
 
-  std::shared_ptr<const UFNode> get_root() const {
-    if (parent == nullptr) {
-      return this->shared_from_this();
-    } else {
-      parent = parent->get_root();
-      assert(parent->parent == nullptr);
-      return parent;
-    }
+  void retain(uint32_t i) {
+    ++refs[i];
   }
 
-  void merge(std::shared_ptr<UFNode>& _rhs) {
-    auto lhs = get_root(), rhs = _rhs->get_root();
-    if (lhs != rhs) {
-      if (lhs > rhs) {
-        std::swap(lhs, rhs);
-      }
-      rhs->parent = lhs;
-      lhs->t += rhs->t;
-      if (log_info) {
-        --get_uf_root_count();
-        if (lhs->t > get_largest()) {
-          get_largest() = lhs->t;
-          std::cout << "new largest uf: " << get_largest() << ", total uf root count: " << get_uf_root_count() << ", total uf node count: " << get_uf_node_count() << std::endl;
-          if (log_to.is_open()) {
-            nlohmann::json j;
-            j["name"] = "largest_uf";
-            j["timestamp"] = timestamp();
-            j["value"] = get_largest().count();
-            j["total_uf_root_count"] = get_uf_root_count();
-            j["total_uf_node_count"] = get_uf_node_count();
-            log_to << j << std::endl;
-          }
-        }
+  void release(uint32_t i) {
+    while (--refs[i] == 0) {
+      uint32_t p = parent[i];
+      free_slots.push_back(i);
+      if (p == i) {
+        --root_count;
+        return;
       }
+      i = p;
     }
   }
 
-  explicit UFNode(const T& t) : t(t) {
-    ++get_uf_root_count();
-    ++get_uf_node_count();
-  }
-  explicit UFNode(T&& t) : t(std::move(t)) {
-    ++get_uf_root_count();
-    ++get_uf_node_count();
+  // with path halving: every other node on the way get it's grandparent as parent.
+  uint32_t find(uint32_t i) {
+    while (parent[i] != i) {
+      uint32_t p = parent[i];
+      uint32_t g = parent[p];
+      if (g != p) {
+        parent[i] = g;
+        retain(g);
+        release(p);
+      }
+      i = g;
+    }
+    return i;
   }
-  ~UFNode() {
-    if (!parent) {
-      --get_uf_root_count();
+
+  void begin_count() {
+    if (++generation == 0) {
+      std::fill(stamp.begin(), stamp.end(), 0);
+      generation = 1;
     }
-    --get_uf_node_count();
+    counted.clear();
   }
 
-  T value() const {
-    return get_root()->t;
+  // whether [root] is counted for the first time this generation.
+  bool count(uint32_t root) {
+    assert(parent[root] == root);
+    if (stamp[root] == generation) {
+      return false;
+    }
+    stamp[root] = generation;
+    counted.push_back(root);
+    return true;
   }
 
-  template<typename F>
-  void update(const F& f) {
-    auto root = get_root();
-    root->t = f(root->t);
+  // union by size, of two roots.
+  void merge(uint32_t l, uint32_t r) {
+    assert(parent[l] == l && parent[r] == r);
+    if (l == r) {
+      return;
+    }
+    if (size[l] < size[r]) {
+      std::swap(l, r);
+    }
+    parent[r] = l;
+    retain(l);
+    size[l] += size[r];
+    value[l] += value[r];
+    ++version[l];
+    --root_count;
+    if constexpr (trace_enabled(TraceLevel::Info)) {
+      if (value[l] > largest) {
+        largest = value[l];
+        Trace::emit(TraceKind::LargestUF, largest.count(), root_count, node_count());
+      }
+    }
   }
 };
 
+// the arena UF use unless told otherwise, one per thread.
 template<typename T>
+struct ThreadLocalUFArena {
+  static UFArena<T>& get() {
+    thread_local UFArena<T> arena;
+    return arena;
+  }
+};
+
+// A handle to a node in [Arena::get()].
+// It move to the root whenever it look it up, so a long lived UF stay one step away from it.
+template<typename T, typename Arena = ThreadLocalUFArena<T>>
 struct UF {
-  mutable std::shared_ptr<UFNode<T>> ptr;
+  mutable uint32_t idx;
 
-  std::shared_ptr<UFNode<T>> get_root() {
-    ptr = ptr->get_root();
-    return ptr;
-  }
-  std::shared_ptr<const UFNode<T>> get_root() const {
-    ptr = ptr->get_root();
-    return ptr;
+  uint32_t get_root() const {
+    UFArena<T>& arena = Arena::get();
+    uint32_t root = arena.find(idx);
+    if (root != idx) {
+      arena.retain(root);
+      arena.release(idx);
+      idx = root;
+    }
+    return root;
   }
 
-  explicit UF(const T& t) : ptr(std::make_shared<UFNode<T>>(t)) { }
-  explicit UF(T&& t) : ptr(std::make_shared<UFNode<T>>(std::move(t))) { }
+  explicit UF(const T& t) : idx(Arena::get().make(t)) { }
   UF() = delete;
+  // another handle to the node at [idx].
+  static UF of_slot(uint32_t idx) {
+    Arena::get().retain(idx);
+    return UF(idx);
+  }
+  UF(const UF& rhs) : idx(rhs.idx) {
+    Arena::get().retain(idx);
+  }
+  UF(UF&& rhs) : idx(rhs.idx) {
+    rhs.idx = UFArena<T>::none;
+  }
+  UF& operator=(const UF& rhs) {
+    if (idx != rhs.idx) {
+      Arena::get().retain(rhs.idx);
+      release();
+      idx = rhs.idx;
+    }
+    return *this;
+  }
+  UF& operator=(UF&& rhs) {
+    if (this != &rhs) {
+      release();
+      idx = rhs.idx;
+      rhs.idx = UFArena<T>::none;
+    }
+    return *this;
+  }
+  ~UF() {
+    release();
+  }
+
+  void release() {
+    if (idx != UFArena<T>::none) {
+      Arena::get().release(idx);
+    }
+  }
+
+private:
+  explicit UF(uint32_t idx) : idx(idx) { }
 
+public:
   void merge(UF& rhs) {
-    rhs.get_root();
-    get_root()->merge(rhs.ptr);
+    uint32_t r = rhs.get_root();
+    Arena::get().merge(get_root(), r);
   }
   T value() const {
-    return get_root()->value();
+    uint32_t root = get_root();
+    return Arena::get().value[root];
   }
   bool operator <(const UF& rhs) const {
     return get_root() < rhs.get_root();
@@ -134,22 +228,50 @@ struct UF {
   }
   template<typename F>
   void update(const F& f) {
-    return ptr->update(f);
+    uint32_t root = get_root();
+    UFArena<T>& arena = Arena::get();
+    arena.value[root] = f(arena.value[root]);
+    ++arena.version[root];
+  }
+  // invalidate the memoized sums over this set, without changing it's value.
+  void bump() {
+    uint32_t root = get_root();
+    ++Arena::get().version[root];
   }
 };
 
-template <typename T>
-struct std::hash<UF<T>> {
-  std::size_t operator()(const UF<T>& t) const {
-    return std::hash<std::shared_ptr<UFNode<T>>>()(t.ptr->get_root());
+template <typename T, typename Arena>
+struct std::hash<UF<T, Arena>> {
+  std::size_t operator()(const UF<T, Arena>& t) const {
+    return std::hash<uint32_t>()(t.get_root());
+  }
+};
+
+// The distinct sets of a summation, without hashing nor allocating:
+// a root is stamped with the generation it was counted in.
+// One at a time per arena, as the stamps are.
+template<typename T, typename Arena = ThreadLocalUFArena<T>>
+struct UFCounted {
+  UFCounted() {
+    Arena::get().begin_count();
+  }
+  UFCounted(const UFCounted&) = delete;
+
+  // whether the set of [uf] is counted for the first time.
+  bool insert(const UF<T, Arena>& uf) {
+    return Arena::get().count(uf.get_root());
+  }
+
+  const std::vector<uint32_t>& roots() const {
+    return Arena::get().counted;
   }
 };
 
 // normal set cannot store UF, as the UF may merge and become equal.
 // this data structure allow change and additionally compact and remove duplicate UF.
-template<typename T>
+template<typename T, typename Arena = ThreadLocalUFArena<T>>
 struct UFSet {
-  mutable std::vector<UF<T>> data;
+  mutable std::vector<UF<T, Arena>> data;
   //mutable UF<T> unique = UF<T>(0);
 
   void fixup(size_t idx) const {
@@ -171,11 +293,8 @@ struct UFSet {
     return data.size();
   }
 
-  void insert(const UF<T>& uf) {
-    if (log_info) {
-      //std::cout << "UFS size: " << data.size() << " unique: " << unique.value() << std::endl;
-      std::cout << "UFS size: " << data.size() << std::endl;
-    }
+  void insert(const UF<T, Arena>& uf) {
+    ZOMBIE_TRACE(TraceLevel::Debug, TraceKind::UFSetInsert, data.size());
     data.push_back(uf);
 
     // alright, it is super unclear what's the right amount of fixing we should do.
@@ -197,33 +316,31 @@ struct UFSet {
   }
 
   T sum() const {
-    std::unordered_set<UF<T>> counted;
+    UFCounted<T, Arena> counted;
     return sum(counted);
   }
 
-  T sum(std::unordered_set<UF<T>>& counted) const {
+  // drop the UF already counted from data, in place, as size() is part of the cost model (see space_taken()).
+  T sum(UFCounted<T, Arena>& counted) const {
     T result(0);
-    std::vector<UF<T>> new_data;
-    for (const UF<T>& uf: data) {
-      if (counted.insert(uf).second) {
-        result += uf.value();
-        new_data.push_back(uf);
+    size_t kept = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+      if (counted.insert(data[i])) {
+        result += data[i].value();
+        if (kept != i) {
+          data[kept] = std::move(data[i]);
+        }
+        ++kept;
       }
     }
-
-    // assert() is unique
-    //if (counted.insert(unique).second) {
-    //  result += unique.value();
-    //}
-
-    data = std::move(new_data);
+    data.erase(data.begin() + kept, data.end());
     return result;
   }
 
   // after merging the UF set is no longer usable as unique is no longer unique.
   // it should be good to force this property.
-  void merge(UF<T>& with) const {
-    for (UF<T>& uf : data) {
+  void merge(UF<T, Arena>& with) const {
+    for (UF<T, Arena>& uf : data) {
       uf.merge(with);
     }
     //unique.merge(with);
@@ -231,3 +348,53 @@ struct UFSet {
     data.push_back(with);
   }
 };
+
+// A sum over distinct UF, memoized.
+// It remember the roots it was computed from and their versions,
+// and stay valid as long as every one of them is still a root, at the same version.
+// So it is invalidated only by a merge (or update) that actually touch it.
+template<typename T, typename Arena = ThreadLocalUFArena<T>>
+struct UFMemo {
+  // each hold it's root, so the slot is not reused while remembered.
+  std::vector<std::pair<UF<T, Arena>, uint64_t>> roots;
+  T value = T(0);
+  bool valid = false;
+
+  bool fresh() const {
+    if (!valid) {
+      return false;
+    }
+    const UFArena<T>& arena = Arena::get();
+    for (const auto& [root, version] : roots) {
+      if (arena.parent[root.idx] != root.idx || arena.version[root.idx] != version) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // [counted] hold the UF summed into [v], each one once.
+  void set(const std::unordered_set<UF<T, Arena>>& counted, const T& v) {
+    roots.clear();
+    for (const UF<T, Arena>& uf : counted) {
+      uint32_t root = uf.get_root();
+      roots.emplace_back(uf, Arena::get().version[root]);
+    }
+    value = v;
+    valid = true;
+  }
+
+  // the same, reusing the capacity of roots.
+  void set(const UFCounted<T, Arena>& counted, const T& v) {
+    roots.clear();
+    for (uint32_t root : counted.roots()) {
+      roots.emplace_back(UF<T, Arena>::of_slot(root), Arena::get().version[root]);
+    }
+    value = v;
+    valid = true;
+  }
+
+  void invalidate() {
+    valid = false;
+  }
+};
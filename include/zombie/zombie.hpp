@@ -9,6 +9,7 @@
 #include "zombie_types.hpp"
 #include "trailokya.hpp"
 #include "zombie_impl.hpp"
+#include "plan.hpp"
 
 #define IMPORT_ZOMBIE(cfg)                                                                         \
   template<typename T>                                                                             \
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <type_traits>
 #include <set>
+#include <algorithm>
 
 #include "zombie/zombie.hpp"
 #include "zombie/common.hpp"
@@ -18,32 +19,107 @@ EZombieNode<cfg>::EZombieNode(Tock created_time)
 
 template<const ZombieConfig& cfg>
 void EZombieNode<cfg>::accessed() const {
-  auto context = get_context();
-  if (context) {
-    context->accessed();
-  }
+  Trailokya<cfg>::get_trailokya().record_access(created_time, [&]() { return get_context().get(); });
 }
 
+
 inline size_t tock_to_index(const Tock& t, const Tock& context_created_time) {
   assert(t > context_created_time);
   return t.tock - context_created_time.tock - 1;
 }
 
+template<const ZombieConfig& cfg>
+void Trailokya<cfg>::drain_access_buffer() {
+  AccessBuffer& buffer = access_buffer();
+  // in tock order, so all the accesses to one context are next to each other and apply as one.
+  std::sort(buffer.accesses.begin(), buffer.accesses.end(),
+            [](const auto& l, const auto& r) { return l.tock < r.tock; });
+  ns now = meter.raw_time();
+  ContextNode<cfg>* context = nullptr;
+  size_t count = 0;
+  ns time(0);
+  auto apply = [&]() {
+    if (context != nullptr) {
+      context->accessed(track_access_time ? time : now, count);
+    }
+    count = 0;
+    time = ns(0);
+  };
+  for (const auto& access : buffer.accesses) {
+    ContextNode<cfg>* c = access.context;
+    if (c == nullptr) {
+      auto* node = akasha.find_le_node(access.tock);
+      if (node == nullptr || tock_to_index(access.tock, node->k) >= node->v->ez.size()) {
+        continue;
+      }
+      c = node->v.get();
+    }
+    if (c != context) {
+      apply();
+      context = c;
+    }
+    count += access.count;
+    time = std::max(time, access.time);
+  }
+  apply();
+  buffer.accesses.clear();
+  counters.hits += buffer.hits;
+  buffer.hits = 0;
+}
+
+template<const ZombieConfig& cfg>
+UFArena<Time>& RuntimeUFArena<cfg>::get() {
+  return Trailokya<cfg>::get_trailokya().uf_arena;
+}
+
+template<const ZombieConfig& cfg>
+ZombieStats Trailokya<cfg>::stats() {
+  auto guard = lock();
+  ZombieStats ret;
+  ret.resident_bytes = resident_bytes;
+  ret.resident_values = resident_values;
+  ret.metadata_bytes =
+    context_bytes +
+    akasha.memory_bytes() +
+    book.size() * (sizeof(typename decltype(book)::Node) + sizeof(RecomputeLater<cfg>)) +
+    uf_arena.node_count() * UFArena<Time>::slot_bytes;
+  ret.contexts = akasha.size;
+  ret.hits = counters.hits;
+  ret.rematerializations = counters.rematerializations;
+  ret.replays = counters.replays;
+  ret.max_replay_depth = counters.max_replay_depth;
+  ret.evictions = counters.evictions;
+  ret.adjust_pop_repushes = book.repush_count;
+  ret.adjust_pop_repushes_avoided = book.repush_avoided_count;
+  ret.cost_evaluations = counters.cost_evaluations;
+  ret.cost_memo_hits = counters.cost_memo_hits;
+  ret.heap_size = book.size();
+  ret.book_entries_removed = counters.book_entries_removed;
+  ret.heap_tombstones = book.count_if([](const std::unique_ptr<Phantom>& p) { return p->dead(); });
+  ret.L = book.L;
+  ret.recompute_time = recompute_time;
+  return ret;
+}
+
 template<const ZombieConfig& cfg>
 FullContextNode<cfg>::~FullContextNode() {
-  // if (pool_index != -1) {
-  //   assert(pool_index >= 0);
-  //   Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
-  //   t.book.heap.remove(pool_index);
-  // }
-  // we decided to not do this. instead pool_index might hold stale pointers.
+  // destroyed without being evicted, e.g. replaced by a replay of itself after it's values were evicted one by one.
+  // the entry would otherwise stay in the book for good, as a tombstone evicting nothing.
+  if (pool_index >= 0) {
+    Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+    t.book.remove(pool_index);
+    ++t.counters.book_entries_removed;
+  } else if (pool_index == waiting_index) {
+    Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+    t.counters.book_entries_removed += t.book.remove_unindexed_if([](const std::unique_ptr<Phantom>& p) { return p->dead(); });
+  }
 }
 
 template<const ZombieConfig& cfg>
-void FullContextNode<cfg>::accessed() {
-  last_accessed = Trailokya<cfg>::get_trailokya().meter.raw_time();
-  if (pool_index != -1) {
-    assert(pool_index >= 0);
+void FullContextNode<cfg>::accessed(const ns& time, size_t count) {
+  last_accessed = time;
+  access_count += count;
+  if (pool_index >= 0) {
     Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
     t.book.touch(pool_index);
   }
@@ -55,7 +131,7 @@ void FullContextNode<cfg>::evict() {
   size_t s = this->ez.size();
   this->ez.clear();
 
-  UF<Time> cost(time_taken);
+  TimeUF<cfg> cost(time_taken);
   this->forward_uf.merge(cost);
   this->backward_uf.merge(cost);
   backedges.merge(cost);
@@ -67,52 +143,51 @@ void FullContextNode<cfg>::evict() {
     n->v->backward_uf.merge(cost);
   }
 
-  auto* parent_node = t.akasha.find_precise_node(this->start_t)->parent;
-  auto& parent_context = parent_node->v;
+  auto* node = t.akasha.find_precise_node(this->start_t);
+  auto& parent_context = node->prev()->v;
   parent_context->backward_uf.merge(cost);
 
-  if (false && log_info) {
-    std::cout << "evicting " << this->start_t << ", cost: " << cost.value().count() << ", in book as: " << this->cost()
-              << " gd heap size: " << t.book.size() << " gd L: " << t.book.L << std::endl;
-    if (log_to.is_open()) {
-      nlohmann::json j;
-      j["name"] = "evict";
-      j["t"] = this->start_t.tock;
-      j["timestamp"] = timestamp();
-      j["cost"] = cost.value().count();
-      log_to << j << std::endl;
-    }
-  }
+  ++t.counters.evictions;
+
+  ZOMBIE_TRACE(TraceLevel::Info, TraceKind::Evict, this->start_t.tock, cost.value().count(), t.book.size());
   // this line delete this;
-  t.akasha.remove_precise(this->start_t);
+  t.akasha.remove(node);
 }
 
+// the neighbour cost is pulled, not pushed to the readers on every merge:
+// a merged root in a chain has ~50 live readers, and rekeying them all cost more than the stale entry adjust_pop repush.
 template<const ZombieConfig& cfg>
 Time FullContextNode<cfg>::time_cost() {
   Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
-  std::unordered_set<UF<Time>> counted;
+  if (cost_memo.fresh()) {
+    ++t.counters.cost_memo_hits;
+    return time_taken + cost_memo.value;
+  }
+  ++t.counters.cost_evaluations;
+  UFCounted<Time, RuntimeUFArena<cfg>> counted;
   Time cost = time_taken;
 
-  if (counted.insert(this->forward_uf).second) {
+  if (counted.insert(this->forward_uf)) {
     cost += this->forward_uf.value();
   }
-  if (counted.insert(this->backward_uf).second) {
+  if (counted.insert(this->backward_uf)) {
     cost += this->backward_uf.value();
   }
   cost += backedges.sum(counted);
 
   for (const Tock& input: dependencies) {
     auto *n = t.akasha.find_le_node(input);
-    auto uf = n->v->backward_uf;
-    if (counted.insert(uf).second) {
+    const auto& uf = n->v->backward_uf;
+    if (counted.insert(uf)) {
       cost += uf.value();
     }
   }
-  auto* parent_node = t.akasha.find_precise_node(this->start_t)->parent;
-  auto uf = parent_node->v->backward_uf;
-  if (counted.insert(uf).second) {
+  auto* parent_node = t.akasha.find_precise_node(this->start_t)->prev();
+  const auto& uf = parent_node->v->backward_uf;
+  if (counted.insert(uf)) {
     cost += uf.value();
   }
+  cost_memo.set(counted, cost - time_taken);
   return cost;
 }
 
@@ -121,6 +196,19 @@ cost_t FullContextNode<cfg>::cost() {
   return cfg.metric(time_taken, time_cost(), Space(this->space_taken()));
 }
 
+template<const ZombieConfig& cfg>
+cost_t FullContextNode<cfg>::policy_cost() {
+  if constexpr (cfg.eviction_policy == EvictionPolicy::GDSF) {
+    return cost() * static_cast<cost_t>(access_count);
+  } else if constexpr (cfg.eviction_policy == EvictionPolicy::LRU) {
+    return last_accessed.time.count();
+  } else if constexpr (cfg.eviction_policy == EvictionPolicy::LFU) {
+    return access_count;
+  } else {
+    return cost();
+  }
+}
+
 template<const ZombieConfig& cfg>
 void FullContextNode<cfg>::evict_individual(const Tock& t) {
   this->ez[tock_to_index(t, this->start_t)].reset();
@@ -140,15 +228,21 @@ ContextNode<cfg>::ContextNode(const Tock& start_t, const Tock& end_t,
   end_t(end_t),
   ez(std::move(ez)),
   ez_space_taken(sp),
-  end_rep(rep) {
+  end_rep(rep),
+  metadata_size(sizeof(ContextNode<cfg>) + this->ez.capacity() * sizeof(std::shared_ptr<EZombieNode<cfg>>)) {
   if (start_t + this->ez.size() + 1 != end_t) {
     std::cout << start_t << " " << this->ez.size() << " " << end_t << std::endl;
   }
   assert(start_t + this->ez.size() + 1 == end_t);
 
   Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+  t.context_bytes += metadata_size;
 
   auto* n = t.akasha.find_le(start_t);
+  if (n != nullptr) {
+    // lookups that landed on n now land on this: the costs that read n's backward_uf must be recomputed.
+    (*n)->backward_uf.bump();
+  }
   if (n != nullptr && (*n)->end_t == start_t) {
     // (*n)->evicted_compute_dependents = UF<Time>(0);
   } else {
@@ -157,35 +251,35 @@ ContextNode<cfg>::ContextNode(const Tock& start_t, const Tock& end_t,
   }
 }
 
+template<const ZombieConfig& cfg>
+ContextNode<cfg>::~ContextNode() {
+  Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+  t.context_bytes -= metadata_size;
+  if constexpr (cfg.runtime != RuntimeMode::Shared) {
+    for (auto& access : t.access_buffer().accesses) {
+      if (access.context == this) {
+        access.context = nullptr;
+      }
+    }
+  }
+}
+
 template<const ZombieConfig& cfg>
 void ContextNode<cfg>::replay() {
   Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
 
   auto* ptr = dynamic_cast<FullContextNode<cfg>*>(this);
-  if (ptr && ptr->pool_index != -1) {
-    assert(ptr->pool_index >= 0);
+  if (ptr && ptr->pool_index >= 0) {
     t.book.touch(ptr->pool_index);
   }
 
-  Time cost = backward_uf.value();
   Tock tock = t.current_tock;
   assert(this->end_t < t.replays.back().forward_at);
   Tock from = this->end_t;
-  if (log_info) {
-    std::cout << "replaying from [" << this->start_t << ", " << this->end_t << ")"
-              << " to " << t.replays.back().forward_at
-              << " diff(/" << unroll_factor << ") " << (t.replays.back().forward_at - from).tock / unroll_factor + 1
-              << " requested at " << t.current_tock
-              << ", cost " << cost.count()
-              << ", depth " << t.replays.size() << std::endl;
-    if (log_to.is_open()) {
-      nlohmann::json j;
-      j["name"] = "replay_begin";
-      j["timestamp"] = timestamp();
-      j["depth"] = t.replays.size();
-      log_to << j << std::endl;
-    }
-  }
+  ++t.counters.replays;
+  // replays[0] is the sentinel for normal execution.
+  t.counters.max_replay_depth = std::max(t.counters.max_replay_depth, t.replays.size() - 1);
+  ZOMBIE_TRACE(TraceLevel::Info, TraceKind::ReplayBegin, this->start_t.tock, t.replays.back().forward_at.tock, t.replays.size());
   bracket(
     [&]() {
       t.current_tock = from;
@@ -197,7 +291,7 @@ void ContextNode<cfg>::replay() {
         Tock old_tock = t.current_tock;
         t.records.back()->play();
         assert(old_tock < t.current_tock);
-        t.each_step();
+        t.step();
       }
     },
     [&]() {
@@ -206,16 +300,7 @@ void ContextNode<cfg>::replay() {
       t.records.pop_back();
       t.current_tock = tock;
     });
-  if (log_info) {
-    std::cout << "replaying done, depth" << t.replays.size() << std::endl;
-    if (log_to.is_open()) {
-      nlohmann::json j;
-      j["name"] = "replay_end";
-      j["timestamp"] = timestamp();
-      j["depth"] = t.replays.size();
-      log_to << j << std::endl;
-    }
-  }
+  ZOMBIE_TRACE(TraceLevel::Info, TraceKind::ReplayEnd, this->start_t.tock, 0, t.replays.size());
 }
 
 template<const ZombieConfig& cfg>
@@ -234,27 +319,57 @@ std::shared_ptr<ContextNode<cfg>> EZombieNode<cfg>::get_context() const {
 
 template<const ZombieConfig& cfg, typename T>
 template<typename... Args>
-ZombieNode<cfg, T>::ZombieNode(Tock created_time, Args&&... args) : EZombieNode<cfg>(created_time), t(std::forward<Args>(args)...) { }
+ZombieNode<cfg, T>::ZombieNode(Tock created_time, Args&&... args) : EZombieNode<cfg>(created_time), t(std::forward<Args>(args)...) {
+  size_t size = GetSize<T>()(t);
+  auto& trailokya = Trailokya<cfg>::get_trailokya();
+  ++trailokya.resident_values;
+  size_t resident = (trailokya.resident_bytes += size);
+  ZOMBIE_TRACE(TraceLevel::Info, TraceKind::Resident, created_time.tock, resident, static_cast<int64_t>(size));
+}
+
+template<const ZombieConfig& cfg, typename T>
+ZombieNode<cfg, T>::~ZombieNode() {
+  size_t size = GetSize<T>()(t);
+  auto& trailokya = Trailokya<cfg>::get_trailokya();
+  --trailokya.resident_values;
+  size_t resident = (trailokya.resident_bytes -= size);
+  ZOMBIE_TRACE(TraceLevel::Info, TraceKind::Resident, this->created_time.tock, resident, -static_cast<int64_t>(size));
+}
 
 template<const ZombieConfig& cfg>
 std::weak_ptr<EZombieNode<cfg>> EZombie<cfg>::ptr() const {
-  if (ptr_cache.expired()) {
+  std::weak_ptr<EZombieNode<cfg>> ret = ptr_cache.load();
+  if (ret.expired()) {
     Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+    auto guard = t.lock();
     auto* node = t.akasha.find_le_node(created_time);
     if (node != nullptr) {
       size_t idx = tock_to_index(created_time, node->k);
       if (idx < node->v->ez.size()) {
-        ptr_cache = node->v->ez[idx];
+        ret = node->v->ez[idx];
+        ptr_cache = ret;
       }
     }
   }
-  return ptr_cache;
+  return ret;
+}
+
+template<const ZombieConfig& cfg>
+bool EZombie<cfg>::evictable() const {
+  auto guard = Trailokya<cfg>::get_trailokya().lock();
+  auto ptr = this->ptr().lock();
+  if (ptr != nullptr) {
+    auto ctx = ptr->get_context();
+    return ctx != nullptr && ctx->evictable();
+  } else {
+    return false;
+  }
 }
 
 template<const ZombieConfig& cfg>
 cost_t RecomputeLater<cfg>::cost() const {
   if (auto ptr = weak_ptr.lock()) {
-    return ptr->cost();
+    return ptr->policy_cost();
   } else {
     return 0;
   }
@@ -267,39 +382,61 @@ void RecomputeLater<cfg>::evict() {
   }
 }
 
+template<const ZombieConfig& cfg>
+bool RecomputeLater<cfg>::pinned() const {
+  auto ptr = weak_ptr.lock();
+  return ptr && Trailokya<cfg>::get_trailokya().pinned(*ptr);
+}
+
 template<const ZombieConfig& cfg>
 void EZombie<cfg>::evict() {
+  auto guard = Trailokya<cfg>::get_trailokya().lock();
   if (evictable()) {
     this->ptr().lock()->get_context()->evict_individual(this->created_time);
   }
 }
 
+// the context whose replay bring back the value created at [created_time]: the one ending before it.
+template<const ZombieConfig& cfg>
+Context<cfg> replay_context(const Tock& created_time) {
+  auto& t = Trailokya<cfg>::get_trailokya();
+  auto* n = t.akasha.find_le_node(created_time);
+  if (!(n->v->end_t < created_time)) {
+    n = n->prev();
+  }
+  return n->v;
+}
+
 template<const ZombieConfig& cfg>
 std::shared_ptr<EZombieNode<cfg>> EZombie<cfg>::shared_ptr() const {
+  if constexpr (cfg.runtime == RuntimeMode::Shared) {
+    // the lock free hit path.
+    if (auto ret = ptr_cache.lock()) {
+      ++Trailokya<cfg>::access_buffer().hits;
+      return ret;
+    }
+  }
+  auto& t = Trailokya<cfg>::get_trailokya();
+  auto guard = t.lock();
   auto ret = ptr().lock();
   if (ret) {
+    ++t.counters.hits;
     return ret;
   } else {
-    auto& t = Trailokya<cfg>::get_trailokya();
+    ++t.counters.rematerializations;
     std::shared_ptr<EZombieNode<cfg>> strong;
     ns begin_time = t.meter.raw_time();
-    if (log_to.is_open() && t.replays.size() == 1) {
-      nlohmann::json j;
-      j["name"] = "current_tock_change";
-      j["timestamp"] = timestamp();
-      j["value"] = t.current_tock.tock;
-      log_to << j << std::endl;
+    if (t.replays.size() == 1) {
+      ZOMBIE_TRACE(TraceLevel::Info, TraceKind::CurrentTockChange, t.current_tock.tock);
     }
     bracket([&]() {
         t.replays.push_back(Replay<cfg> { created_time, &strong });
       },
       [&]() {
         t.meter.block([&](){
-          auto* n = t.akasha.find_le_node(created_time);
-          if (!(n->v->end_t < created_time)) {
-            n = n->parent;
-          }
-          n->v->replay();
+          // hold the context: eviction during replay may drop it from akasha.
+          Context<cfg> context = replay_context<cfg>(created_time);
+          context->replay();
         });
       },
       [&]() {
@@ -318,6 +455,7 @@ template<const ZombieConfig& cfg, typename T>
 template<typename... Args>
 void Zombie<cfg, T>::construct(Args&&... args) {
   Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+  auto guard = t.lock();
   this->created_time = t.current_tock++;
   if (this->created_time != std::numeric_limits<Tock>::max()) {
     auto shared = std::make_shared<ZombieNode<cfg, T>>(this->created_time, std::forward<Args>(args)...);
@@ -329,6 +467,7 @@ void Zombie<cfg, T>::construct(Args&&... args) {
     if (this->created_time == t.replays.back().forward_at) {
       *t.replays.back().forward_to = shared;
     }
+    t.reaper.enforce_budget();
   }
 }
 
@@ -390,11 +529,15 @@ FullContextNode<cfg>::FullContextNode(const Tock& start_t,
   dependencies(std::move(deps)) {
 
   Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+  size_t extra_metadata_size = sizeof(FullContextNode<cfg>) - sizeof(ContextNode<cfg>) + dependencies.capacity() * sizeof(Tock);
+  this->metadata_size += extra_metadata_size;
+  t.context_bytes += extra_metadata_size;
 
   for (const Tock& input: dependencies) {
     auto* n = t.akasha.find_le_node(input);
     if (auto* ptr = dynamic_cast<FullContextNode<cfg>*>(n->v.get())) {
       ptr->backedges.insert(forward_uf);
+      ptr->cost_memo.invalidate();
     }
   }
 
@@ -402,7 +545,7 @@ FullContextNode<cfg>::FullContextNode(const Tock& start_t,
   /*
   // we are replaying
   if (false && t.replays.size() > 1) {
-    std::unordered_set<UF<Time>> updated;
+    std::unordered_set<TimeUF<cfg>> updated;
 
     for (const Tock& input: dependencies) {
       auto* n = t.akasha.find_le_node(input);
@@ -426,8 +569,8 @@ FullContextNode<cfg>::FullContextNode(const Tock& start_t,
 template<const ZombieConfig& cfg>
 void RootRecordNode<cfg>::suspended(const Replayer<cfg>& rep) {
   Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
-  t.akasha.insert(this->t, std::make_shared<RootContextNode<cfg>>(this->t, t.current_tock,
-                                                                  std::move(this->ez), this->space_taken, rep));
+  t.akasha.insert(this->t, t.template make_context<RootContextNode<cfg>>(this->t, t.current_tock,
+                                                                        std::move(this->ez), this->space_taken, rep));
 }
 
 constexpr bool use_measured_time = false;
@@ -437,38 +580,25 @@ void HeadRecordNode<cfg>::completed(const Replayer<cfg>& rep) {
   Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
   assert(this->t < t.replays.back().forward_at);
   std::vector<Tock> deps;
-  std::vector<int64_t> deps_copy;
   for (const auto& i: this->rep->in) {
     this->dependencies.insert(i.created_time);
   }
   for (const auto& i: this->dependencies) {
     deps.push_back(i);
-    deps_copy.push_back(i.tock);
   }
   auto time_taken = use_measured_time ? Time(Trailokya<cfg>::get_trailokya().meter.time()) - start_time : Time(ns(plank_time_in_nanoseconds));
   // std::cout << time_taken.count() << std::endl;
-  auto fc = std::make_shared<FullContextNode<cfg>>(this->t,
-                                                   t.current_tock,
-                                                   std::move(this->ez),
-                                                   this->space_taken,
-                                                   time_taken,
-                                                   rep,
-                                                   std::move(deps));
+  auto fc = t.template make_context<FullContextNode<cfg>>(this->t,
+                                                          t.current_tock,
+                                                          std::move(this->ez),
+                                                          this->space_taken,
+                                                          time_taken,
+                                                          rep,
+                                                          std::move(deps));
   t.akasha.insert(this->t, fc);
-  if (log_info) {
-    std::cout << "inserting: " << this->t << ", cost: " << fc->time_cost() << ", time_taken: " << time_taken << std::endl;
-    if (log_to.is_open()) {
-      nlohmann::json j;
-      j["name"] = "insert_context";
-      j["t"] = this->t.tock;
-      j["deps"] = deps_copy;
-      j["timestamp"] = timestamp();
-      j["time_taken"] = time_taken.count();
-      j["splaylist_size"] = t.akasha.size;
-      log_to << j << std::endl;
-    }
-  }
-  t.book.push(std::make_unique<RecomputeLater<cfg>>(fc), fc->cost());
+  ZOMBIE_TRACE(TraceLevel::Info, TraceKind::InsertContext, this->t.tock, time_taken.count(), t.akasha.size);
+  fc->pool_index = FullContextNode<cfg>::waiting_index;
+  t.book.push(std::make_unique<RecomputeLater<cfg>>(fc), fc->policy_cost());
 }
 
 template<const ZombieConfig& cfg>
@@ -479,15 +609,21 @@ Tock tick() {
 template<const ZombieConfig& cfg>
 void HeadRecordNode<cfg>::play() {
   assert(!played);
-  Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+  played = true;
+  // finishing replace this record, so keep what we still use alive on the stack.
+  Replayer<cfg> rep = this->rep;
   std::vector<std::shared_ptr<EZombieNode<cfg>>> storage;
   std::vector<const void*> in;
+  // missing inputs are replayed one after the other, even when independent.
+  // a replay drive the runtime's single record stack and current_tock, and insert into akasha as it go,
+  // so two cannot run at once. nor does the order matter: a replay bring back every value of the contexts it replay,
+  // and a function cannot bind within itself (only tailcall), so an input do not come back on the way to another,
+  // short of a tailcall chain running past unroll_factor.
   for (const EZombie<cfg>& input : rep->in) {
     storage.push_back(input.shared_ptr());
     in.push_back(storage.back()->get_ptr());
   }
   (rep->f)(in);
-  played = true;
 }
 
 template<const ZombieConfig& cfg, typename F, typename... Arg>
@@ -495,6 +631,7 @@ auto bindZombie(F&& f, const Zombie<cfg, Arg>& ...x) {
   using ret_type = decltype(f(std::declval<Arg>()...));
   static_assert(IsExternalZombie<ret_type>::value, "should be zombie");
   Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+  auto guard = t.lock();
   assert(t.current_tock != t.replays.back().forward_at);
   if (t.current_tock < t.replays.back().forward_at) {
     replay_func<cfg> func =
@@ -509,6 +646,7 @@ auto bindZombie(F&& f, const Zombie<cfg, Arg>& ...x) {
     t.records.back()->suspend(std::make_shared<ReplayerNode<cfg>>(std::move(func), std::move(in)));
     t.records.back()->play();
     ExternalEZombie<cfg> ez = t.records.back()->pop_value();
+    t.reclaimer.step();
     return ret_type(std::move(ez));
   } else {
     return ret_type(std::numeric_limits<Tock>::max());
@@ -621,6 +759,7 @@ auto bindZombieTC(F&& f, const Zombie<cfg, Arg>& ...x) {
   using result_type = TCZombieToExternalZombie<tc_result_type>::type;
 
   Trailokya<cfg>& t = Trailokya<cfg>::get_trailokya();
+  auto guard = t.lock();
   Replayer<cfg> rep = InitTailCall<cfg>(std::forward<F>(f), x...);
   t.records.back()->suspend(rep);
 
@@ -628,7 +767,7 @@ auto bindZombieTC(F&& f, const Zombie<cfg, Arg>& ...x) {
     Tock old_tock = t.current_tock;
     t.records.back()->play();
     assert(old_tock < t.current_tock);
-    t.each_step();
+    t.step();
   }
 
   ExternalEZombie<cfg> ret = t.records.back()->pop_value();
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <vector>
+#include <atomic>
 #include <functional>
 
 #include "tock/tock.hpp"
@@ -28,6 +29,49 @@ struct EZombie;
 template<const ZombieConfig &cfg, typename T>
 struct Zombie;
 
+// A weak_ptr used as a cache.
+// In RuntimeMode::Shared the hit path read it without holding the runtime lock,
+// while a miss on another thread may write it, so it has to be atomic there.
+template<typename T, bool is_atomic>
+struct WeakCache {
+  std::conditional_t<is_atomic, std::atomic<std::weak_ptr<T>>, std::weak_ptr<T>> ptr;
+
+  WeakCache() { }
+  WeakCache(const WeakCache& rhs) : ptr(rhs.load()) { }
+  WeakCache& operator=(const WeakCache& rhs) {
+    store(rhs.load());
+    return *this;
+  }
+  WeakCache& operator=(const std::weak_ptr<T>& rhs) {
+    store(rhs);
+    return *this;
+  }
+
+  std::weak_ptr<T> load() const {
+    if constexpr (is_atomic) {
+      return ptr.load(std::memory_order_acquire);
+    } else {
+      return ptr;
+    }
+  }
+
+  void store(const std::weak_ptr<T>& rhs) {
+    if constexpr (is_atomic) {
+      ptr.store(rhs, std::memory_order_release);
+    } else {
+      ptr = rhs;
+    }
+  }
+
+  std::shared_ptr<T> lock() const {
+    return load().lock();
+  }
+
+  bool expired() const {
+    return load().expired();
+  }
+};
+
 // a phantom type
 template<const ZombieConfig &cfg, typename T>
 struct TCZombie {
@@ -80,6 +124,7 @@ struct ZombieNode : EZombieNode<cfg> {
 
   template<typename... Args>
   ZombieNode(Tock created_time, Args&&... args);
+  ~ZombieNode();
 };
 
 struct Phantom {
@@ -87,6 +132,11 @@ struct Phantom {
   virtual cost_t cost() const = 0;
   virtual void evict() = 0;
   virtual void notify_index_changed(size_t new_index) = 0;
+  virtual void notify_removed() = 0;
+  // what it would evict is already gone.
+  virtual bool dead() const = 0;
+  // what it would evict is still needed, by an executing RecomputePlan: the reaper pass over it.
+  virtual bool pinned() const = 0;
 };
 
 template<const ZombieConfig& cfg, typename T>
@@ -101,7 +151,7 @@ struct Zombie;
 template<const ZombieConfig& cfg>
 struct EZombie {
   Tock created_time;
-  mutable std::weak_ptr<EZombieNode<cfg>> ptr_cache;
+  mutable WeakCache<EZombieNode<cfg>, cfg.runtime == RuntimeMode::Shared> ptr_cache;
 
   EZombie(const EZombie& ez) : created_time(ez.created_time), ptr_cache(ez.ptr_cache) { }
   template<typename T>
@@ -121,15 +171,7 @@ struct EZombie {
     return ptr().lock() == nullptr;
   }
 
-  bool evictable() const {
-    auto ptr = this->ptr().lock();
-    if (ptr != nullptr) {
-      auto ctx = ptr->get_context();
-      return ctx != nullptr && ctx->evictable();
-    } else {
-      return false;
-    }
-  }
+  bool evictable() const;
 
   bool unique() const {
     return ptr().use_count() ==  1;
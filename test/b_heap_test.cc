@@ -0,0 +1,135 @@
+#include <map>
+#include <random>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+// the smallest pages, so a few elements spread over many pages.
+template<typename T, typename NHIC = NotifyHeapIndexChanged<T>, typename NHER = NotifyHeapElementRemoved<T>>
+using SmallPages = BHeap<T, std::less<T>, NHIC, NHER, 32>;
+
+TEST(BHeapTest, Layout) {
+  using H = SmallPages<Element<false>>;
+  static_assert(H::level_in_page == 3);
+  static_assert(H::node_in_page == 6);
+  for (size_t n = 0; n < 10000; ++n) {
+    size_t i = H::nth(n);
+    EXPECT_LT(i, H::nth(n + 1));
+    EXPECT_EQ(H::right_child(i), H::left_child(i) + 1);
+    for (size_t c : {H::left_child(i), H::right_child(i)}) {
+      EXPECT_GT(c, i);
+      EXPECT_EQ(H::parent(c), i);
+    }
+  }
+  // the root page hold the root and two subtrees of two levels.
+  EXPECT_EQ(H::left_child(0), 1);
+  EXPECT_EQ(H::nth(6), 6);
+  // the bottom of the root page lead to the roots of pages 1 to 4, at positions 2 and 3.
+  EXPECT_EQ(H::nth(7), (1 << 3 | 2) - 1);
+  EXPECT_EQ(H::left_child(3), (1 << 3 | 2) - 1);
+  EXPECT_EQ(H::left_child(4), (2 << 3 | 2) - 1);
+  EXPECT_EQ(H::left_child(6), (4 << 3 | 2) - 1);
+  // and a page take 4096 bytes by default.
+  static_assert(BHeap<Element<false>>::node_in_page == 1022);
+}
+
+// sort through the heap, which must give it's pages back as it empty.
+template<typename Heap, bool is_unique>
+void PagedSortTest(size_t count) {
+  Heap h;
+  EXPECT_EQ(SortMismatch<is_unique>(h, count), "");
+  EXPECT_LE(h.pages.size(), 1);
+}
+
+TEST(BHeapTest, Sort) {
+  PagedSortTest<SmallPages<Element<false>>, false>(20);
+  PagedSortTest<SmallPages<Element<false>>, false>(5000);
+  PagedSortTest<SmallPages<Element<true>>, true>(5000);
+  PagedSortTest<BHeap<Element<true>>, true>(5000);
+}
+
+// the NHIC/NHER contract GDHeap rely on: every element know it's index, as MinHeap report it.
+TEST(BHeapTest, IndexNotification) {
+  std::map<int, size_t> index;
+  SmallPages<Tracked, TrackIndex<Tracked>, TrackRemove<Tracked>> h(std::less<Tracked>(), TrackIndex<Tracked>{&index}, TrackRemove<Tracked>{&index});
+  std::default_random_engine re(0);
+  std::uniform_int_distribution<int> dist(0, 1 << 20);
+  auto check = [&]() {
+    ASSERT_EQ(index.size(), h.size());
+    for (const auto& [id, idx] : index) {
+      ASSERT_TRUE(h.has_value(idx));
+      EXPECT_EQ(h[idx].id, id);
+      if (idx != 0) {
+        EXPECT_FALSE(h[idx] < h[decltype(h)::parent(idx)]);
+      }
+    }
+  };
+  int next_id = 0;
+  for (size_t round = 0; round < 2000; ++round) {
+    switch (dist(re) % 4) {
+    case 0:
+    case 1:
+      h.push(Tracked{next_id++, dist(re)});
+      break;
+    case 2:
+      if (!h.empty()) {
+        h.remove(h.nth(dist(re) % h.size()));
+      }
+      break;
+    case 3:
+      if (!h.empty()) {
+        size_t idx = h.nth(dist(re) % h.size());
+        h[idx].key = dist(re);
+        h.rebalance(idx, false);
+      }
+      break;
+    }
+    check();
+  }
+  // like MinHeap, remove_if does not report the moved elements.
+  size_t odd = std::count_if(index.begin(), index.end(), [&](const auto& p) { return h[p.second].key % 2 != 0; });
+  h.remove_if([](const Tracked& t) { return t.key % 2 == 0; }, [](Tracked&&) { });
+  EXPECT_EQ(h.size(), odd);
+  for (size_t n = 1; n < h.size(); ++n) {
+    size_t i = h.nth(n);
+    EXPECT_NE(h[i].key % 2, 0);
+    EXPECT_FALSE(h[i] < h[decltype(h)::parent(i)]);
+  }
+}
+
+constexpr ZombieConfig paged_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_book_heap(BookHeap::Paged);
+
+namespace PagedBook {
+  IMPORT_ZOMBIE(paged_cfg)
+}
+
+TEST(BHeapTest, Book) {
+  using namespace PagedBook;
+  auto& t = Trailokya::get_trailokya();
+  static_assert(std::is_same_v<decltype(t.book.heap),
+                               BHeap<decltype(t.book)::Node, std::less<decltype(t.book)::Node>,
+                                     decltype(t.book)::NHIC_INNER, decltype(t.book)::NHER_INNER>>);
+  constexpr size_t length = 1000;
+  size_t work_done = 0;
+  std::vector<Zombie<int>> zs = {Zombie<int>(0)};
+  for (size_t i = 1; i < length; ++i) {
+    zs.push_back(bindZombie([&](int x) {
+      ++work_done;
+      return Zombie<int>(x + 1);
+    }, zs.back()));
+  }
+  EXPECT_GT(t.book.heap.pages.size(), 1);
+  for (size_t i = 0; i < length; i += 3) {
+    zs[i].get_value();
+  }
+  while (!t.reaper.have_soul()) {
+    t.reaper.murder();
+  }
+  for (size_t i = length; i-- > 0;) {
+    EXPECT_EQ(zs[i].get_value(), i);
+  }
+  EXPECT_GT(work_done, length - 1);
+}
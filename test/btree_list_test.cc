@@ -0,0 +1,118 @@
+#include <map>
+#include <random>
+#include <gtest/gtest.h>
+
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+// small capacities, so a few hundred keys already exercise splits and merges at every level.
+using SmallTree = BTreeList<int, int, 4, 4>;
+
+TEST(BTreeListTest, Empty) {
+  SmallTree tree;
+  EXPECT_FALSE(tree.has_le(0));
+  EXPECT_EQ(tree.find_precise(0), nullptr);
+  tree.remove_precise(0);
+  EXPECT_EQ(tree.size, 0);
+}
+
+TEST(BTreeListTest, AppendThenRemove) {
+  SmallTree tree;
+  std::map<int, int> m;
+  for (int i = 0; i < 500; ++i) {
+    tree.insert(2 * i, i);
+    m[2 * i] = i;
+  }
+  EXPECT_EQ(IndexMismatch(tree, m), "");
+  // appending keep leaves full.
+  EXPECT_LE(tree.leaf_count, 500 / 4 + 1);
+  for (int k = -1; k < 1001; ++k) {
+    EXPECT_EQ(FindLeMismatch(tree, m, k), "");
+  }
+  for (int i = 0; i < 500; i += 3) {
+    tree.remove_precise(2 * i);
+    m.erase(2 * i);
+  }
+  EXPECT_EQ(IndexMismatch(tree, m), "");
+  for (int k = -1; k < 1001; ++k) {
+    EXPECT_EQ(FindLeMismatch(tree, m, k), "");
+  }
+  for (int i = 0; i < 500; ++i) {
+    tree.remove_precise(2 * i);
+  }
+  EXPECT_EQ(tree.size, 0);
+  EXPECT_EQ(tree.root, nullptr);
+  EXPECT_EQ(tree.leaf_count, 0);
+  EXPECT_EQ(tree.inner_count, 0);
+}
+
+TEST(BTreeListTest, RandomAgainstMap) {
+  std::default_random_engine rng(42);
+  std::uniform_int_distribution<int> key(0, 2000);
+  std::uniform_int_distribution<int> op(0, 9);
+  SmallTree tree;
+  std::map<int, int> m;
+  for (int i = 0; i < 20000; ++i) {
+    int k = key(rng);
+    int o = op(rng);
+    if (o < 5) {
+      tree.insert(k, i);
+      m[k] = i;
+    } else if (o < 8) {
+      tree.remove_precise(k);
+      m.erase(k);
+    } else if (o < 9) {
+      tree.remove_le(k);
+      auto it = m.upper_bound(k);
+      if (it != m.begin()) {
+        m.erase(--it);
+      }
+    } else {
+      EXPECT_EQ(FindLeMismatch(tree, m, k), "");
+      EXPECT_EQ(tree.has_precise(k), m.count(k) == 1);
+    }
+    if (i % 1000 == 0) {
+      EXPECT_EQ(IndexMismatch(tree, m), "");
+    }
+  }
+  EXPECT_EQ(IndexMismatch(tree, m), "");
+}
+
+TEST(BTreeListTest, ReleaseValueOnRemove) {
+  BTreeList<int, std::shared_ptr<int>> tree;
+  auto p = std::make_shared<int>(1);
+  tree.insert(1, p);
+  tree.insert(2, std::make_shared<int>(2));
+  EXPECT_EQ(p.use_count(), 2);
+  tree.remove_precise(1);
+  EXPECT_EQ(p.use_count(), 1);
+}
+
+constexpr ZombieConfig btree_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_akasha(AkashaIndex::BTree);
+
+namespace BTreeAkasha {
+  IMPORT_ZOMBIE(btree_cfg)
+}
+
+TEST(BTreeListTest, Akasha) {
+  using namespace BTreeAkasha;
+  static_assert(std::is_same_v<Trailokya::Akasha, BTreeList<Tock, ZombieInternal::Context<btree_cfg>>>);
+  auto& t = Trailokya::get_trailokya();
+  constexpr size_t length = 1000;
+  size_t work_done = 0;
+  std::vector<Zombie<int>> zs = {Zombie<int>(0)};
+  for (size_t i = 1; i < length; ++i) {
+    zs.push_back(bindZombie([&](int x) {
+      ++work_done;
+      return Zombie<int>(x + 1);
+    }, zs.back()));
+  }
+  EXPECT_EQ(work_done, length - 1);
+  while (!t.reaper.have_soul()) {
+    t.reaper.murder();
+  }
+  for (size_t i = length; i-- > 0;) {
+    EXPECT_EQ(zs[i].get_value(), i);
+  }
+  EXPECT_GT(work_done, length - 1);
+}
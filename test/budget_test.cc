@@ -0,0 +1,173 @@
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+#include <thread>
+#include <gtest/gtest.h>
+
+constexpr size_t resource_size = 1 << 16;
+constexpr size_t budget_in_resource = 8;
+
+constexpr ZombieConfig budget_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_memory_budget(budget_in_resource * resource_size);
+
+namespace Budget {
+  IMPORT_ZOMBIE(budget_cfg)
+}
+
+TEST(BudgetTest, ResidentBytes) {
+  using namespace Budget;
+  struct Test {};
+  using Resource = Resource<Test>;
+  auto& t = Trailokya::get_trailokya();
+  size_t before = t.resident_bytes;
+  {
+    Zombie<Resource> x(0);
+    EXPECT_EQ(t.resident_bytes, before + resource_size);
+    Zombie<Resource> y = bindZombie([](const Resource& x) { return Zombie<Resource>(x.value + 1); }, x);
+    EXPECT_EQ(t.resident_bytes, before + 2 * resource_size);
+    y.evict();
+    EXPECT_EQ(t.resident_bytes, before + resource_size);
+    EXPECT_EQ(y.shared_ptr()->get_ref().value, 1);
+    EXPECT_EQ(t.resident_bytes, before + 2 * resource_size);
+  }
+}
+
+TEST(BudgetTest, ForwardBackwardStayInBudget) {
+  using namespace Budget;
+  struct Test {};
+  using Resource = Resource<Test>;
+  auto& t = Trailokya::get_trailokya();
+  constexpr size_t total_size = 100;
+
+  size_t peak = 0;
+  size_t work_done = 0;
+  std::vector<Zombie<Resource>> zs;
+  zs.push_back(bindZombie([&]() {
+    ++work_done;
+    return Zombie<Resource>(0);
+  }));
+  for (size_t i = 1; i < total_size; ++i) {
+    zs.push_back(bindZombie([&](const Resource& x) {
+      ++work_done;
+      peak = std::max<size_t>(peak, t.resident_bytes);
+      return Zombie<Resource>(x.value + 1);
+    }, zs.back()));
+    peak = std::max<size_t>(peak, t.resident_bytes);
+  }
+  for (size_t i = total_size; i-- > 0;) {
+    EXPECT_EQ(zs[i].shared_ptr()->get_ref().value, static_cast<int>(i));
+    peak = std::max<size_t>(peak, t.resident_bytes);
+  }
+  // no call site evicted by hand, yet the runtime kept to the budget.
+  EXPECT_LE(peak, budget_cfg.memory_budget);
+  EXPECT_LE(Resource::count, budget_in_resource);
+  EXPECT_GT(work_done, total_size);
+}
+
+constexpr ZombieConfig watermark_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1})
+  .with_memory_budget(budget_in_resource * resource_size)
+  .with_watermarks(/*high=*/6 * resource_size, /*low=*/3 * resource_size);
+
+namespace Watermark {
+  IMPORT_ZOMBIE(watermark_cfg)
+}
+
+TEST(WatermarkTest, ReclaimBetweenSteps) {
+  using namespace Watermark;
+  struct Test {};
+  using Resource = Resource<Test>;
+  auto& t = Trailokya::get_trailokya();
+  constexpr size_t total_size = 100;
+
+  std::vector<Zombie<Resource>> zs;
+  zs.push_back(bindZombie([&]() { return Zombie<Resource>(0); }));
+  for (size_t i = 1; i < total_size; ++i) {
+    zs.push_back(bindZombie([&](const Resource& x) { return Zombie<Resource>(x.value + 1); }, zs.back()));
+    // after every bind, usage is back under the high watermark.
+    EXPECT_LE(t.resident_bytes, watermark_cfg.watermarks.first);
+  }
+  EXPECT_GT(t.reclaimer.background_runs, 0);
+  EXPECT_GT(t.reclaimer.background_evictions, 0);
+  // the reclaimer kept ahead of the budget, so binding never evicted in the foreground.
+  EXPECT_EQ(t.reclaimer.foreground_stalls, 0);
+  EXPECT_EQ(t.reclaimer.foreground_evictions, 0);
+
+  for (size_t i = total_size; i-- > 0;) {
+    EXPECT_EQ(zs[i].shared_ptr()->get_ref().value, static_cast<int>(i));
+  }
+  EXPECT_LE(Resource::count, budget_in_resource);
+}
+
+constexpr ZombieConfig shared_watermark_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1})
+  .with_runtime(RuntimeMode::Shared)
+  .with_watermarks(/*high=*/6 * resource_size, /*low=*/3 * resource_size);
+
+namespace SharedWatermark {
+  IMPORT_ZOMBIE(shared_watermark_cfg)
+}
+
+TEST(WatermarkTest, SharedReclaimerThread) {
+  using namespace SharedWatermark;
+  struct Test {};
+  using Resource = Resource<Test>;
+  auto& t = Trailokya::get_trailokya();
+  constexpr size_t total_size = 32;
+
+  std::vector<Zombie<Resource>> zs;
+  zs.push_back(bindZombie([&]() { return Zombie<Resource>(0); }));
+  for (size_t i = 1; i < total_size; ++i) {
+    zs.push_back(bindZombie([&](const Resource& x) { return Zombie<Resource>(x.value + 1); }, zs.back()));
+  }
+  // the reclaimer thread catch up eventually.
+  for (size_t i = 0; i < 1000 && t.resident_bytes > shared_watermark_cfg.watermarks.first; ++i) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_LE(t.resident_bytes, shared_watermark_cfg.watermarks.first);
+  {
+    auto guard = t.lock();
+    EXPECT_GT(t.reclaimer.background_runs, 0);
+    EXPECT_GT(t.reclaimer.background_evictions, 0);
+    EXPECT_EQ(t.reclaimer.foreground_evictions, 0);
+  }
+  for (size_t i = total_size; i-- > 0;) {
+    EXPECT_EQ(zs[i].shared_ptr()->get_ref().value, static_cast<int>(i));
+  }
+}
+
+constexpr ZombieConfig reclaim_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1});
+
+namespace Reclaim {
+  IMPORT_ZOMBIE(reclaim_cfg)
+}
+
+TEST(BudgetTest, EvictWhile) {
+  using namespace Reclaim;
+  struct Test {};
+  using Resource = Resource<Test>;
+  auto& t = Trailokya::get_trailokya();
+  constexpr size_t total_size = 50;
+
+  std::vector<Zombie<Resource>> zs = {Zombie<Resource>(0)};
+  for (size_t i = 1; i < total_size; ++i) {
+    zs.push_back(bindZombie([](const Resource& x) { return Zombie<Resource>(x.value + 1); }, zs.back()));
+  }
+  size_t before = t.resident_bytes;
+  size_t evictions = t.counters.evictions;
+  // a single context hold a single resource, so this evict exactly 5 of them.
+  EXPECT_EQ(t.reaper.evict_while([&]() { return before - t.resident_bytes < 5 * resource_size - 1; }), 5);
+  EXPECT_EQ(t.resident_bytes, before - 5 * resource_size);
+  EXPECT_EQ(t.counters.evictions, evictions + 5);
+
+  t.reaper.evict_while([&]() { return t.resident_bytes > 10 * resource_size; });
+  EXPECT_EQ(t.resident_bytes, 10 * resource_size);
+
+  // asking for more than there is empty the book, and stop.
+  EXPECT_EQ(t.reaper.evict_while([]() { return true; }), 9);
+  EXPECT_TRUE(t.reaper.have_soul());
+
+  for (size_t i = total_size; i-- > 0;) {
+    EXPECT_EQ(zs[i].shared_ptr()->get_ref().value, static_cast<int>(i));
+  }
+}
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <map>
 #include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
 
 #define ZOMBIE_KINETIC_VERIFY_INVARIANT
 
@@ -53,6 +58,108 @@ struct GetSize<int> {
   }
 };
 
+// push [count] random values into [h], then pop them all back.
+// return what went wrong, or "" if size() followed the pushes and the values came back sorted.
+template<bool is_unique, typename Heap>
+std::string SortMismatch(Heap& h, size_t count) {
+  std::default_random_engine re(count);
+  std::uniform_int_distribution<int> dist(0, 1000);
+  std::vector<int> v;
+  for (size_t i = 0; i < count; ++i) {
+    v.push_back(dist(re));
+    h.push(Element<is_unique>{v.back()});
+    if (h.size() != v.size()) {
+      return "size " + std::to_string(h.size()) + " after " + std::to_string(v.size()) + " pushes";
+    }
+  }
+  std::sort(v.begin(), v.end());
+  std::vector<int> ret;
+  while (!h.empty()) {
+    ret.push_back(h.pop().get());
+  }
+  if (ret != v) {
+    return "popped out of order";
+  }
+  return "";
+}
+
+// an element of a heap telling TrackIndex and TrackRemove where it is, by [id].
+struct Tracked {
+  int id;
+  int key;
+  bool operator<(const Tracked& r) const { return key < r.key; }
+};
+
+inline int tracked_id(const Tracked& t) {
+  return t.id;
+}
+
+inline int tracked_id(int t) {
+  return t;
+}
+
+// the NHIC of a heap, keeping [index] from id to the index the heap report.
+template<typename T>
+struct TrackIndex {
+  std::map<int, size_t>* index;
+  void operator()(const T& t, size_t idx) {
+    (*index)[tracked_id(t)] = idx;
+  }
+};
+
+// the NHER of a heap, erasing the removed element from [index].
+template<typename T>
+struct TrackRemove {
+  std::map<int, size_t>* index;
+  void operator()(const T& t) {
+    index->erase(tracked_id(t));
+  }
+};
+
+// where the ordered index [index] (an akasha) differ from [m], walking it forward then backward, or "".
+template<typename Index>
+std::string IndexMismatch(const Index& index, const std::map<int, int>& m) {
+  if (index.size != m.size()) {
+    return "size " + std::to_string(index.size) + " instead of " + std::to_string(m.size());
+  }
+  auto* node = m.empty() ? nullptr : index.find_le_node(m.begin()->first);
+  for (const auto& [k, v] : m) {
+    if (node == nullptr || node->k != k || node->v != v) {
+      return "forward walk lost at " + std::to_string(k);
+    }
+    node = node->next();
+  }
+  if (node != nullptr) {
+    return "forward walk past the end";
+  }
+  node = m.empty() ? nullptr : index.find_le_node(m.rbegin()->first);
+  for (auto it = m.rbegin(); it != m.rend(); ++it) {
+    if (node == nullptr || node->k != it->first) {
+      return "backward walk lost at " + std::to_string(it->first);
+    }
+    node = node->prev();
+  }
+  if (node != nullptr) {
+    return "backward walk past the beginning";
+  }
+  return "";
+}
+
+// where [index].find_le_node([k]) differ from [m], or "".
+template<typename Index>
+std::string FindLeMismatch(const Index& index, const std::map<int, int>& m, int k) {
+  auto it = m.upper_bound(k);
+  auto* node = index.find_le_node(k);
+  if (it == m.begin()) {
+    return node == nullptr ? "" : "found " + std::to_string(node->k) + " below the first key, for " + std::to_string(k);
+  }
+  --it;
+  if (node == nullptr || node->k != it->first || node->v != it->second) {
+    return "missed " + std::to_string(it->first) + " for " + std::to_string(k);
+  }
+  return "";
+}
+
 // [test_id] is used to separate different tests
 template<typename test_id>
 struct Resource {
@@ -78,3 +185,45 @@ struct GetSize<Resource<test_id>> {
     return 1 << 16;
   };
 };
+
+template<const ZombieConfig& cfg>
+struct ChainRun {
+  std::vector<ZombieInternal::ExternalZombie<cfg, int>> zs;
+  // times a link was computed, counting recomputation.
+  // shared with the binds, which replay after ForwardBackward return.
+  std::shared_ptr<size_t> work_done = std::make_shared<size_t>(0);
+  // values read back wrong.
+  size_t wrong = 0;
+};
+
+// a chain of [length] binds, each adding one, read back to front.
+// [step] is fast forwarded between binds and between reads,
+// and the book is brought back to at most [book_limit] contexts after each of them.
+template<const ZombieConfig& cfg>
+ChainRun<cfg> ForwardBackward(size_t length, ns step = ns(0), size_t book_limit = 10) {
+  using Z = ZombieInternal::ExternalZombie<cfg, int>;
+  auto& t = ZombieInternal::Trailokya<cfg>::get_trailokya();
+  ChainRun<cfg> ret;
+  auto& zs = ret.zs;
+  zs.push_back(Z(0));
+  auto keep_book = [&]() {
+    t.meter.fast_forward(step);
+    while (t.book.size() > book_limit) {
+      t.reaper.murder();
+    }
+  };
+  for (size_t i = 1; i < length; ++i) {
+    zs.push_back(ZombieInternal::bindZombie<cfg>([work_done = ret.work_done](int x) {
+      ++*work_done;
+      return Z(x + 1);
+    }, zs.back().z));
+    keep_book();
+  }
+  for (size_t i = length; i-- > 0;) {
+    if (zs[i].get_value() != static_cast<int>(i)) {
+      ++ret.wrong;
+    }
+    keep_book();
+  }
+  return ret;
+}
@@ -0,0 +1,153 @@
+#include <map>
+#include <random>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+template<bool is_unique>
+struct ElementKey {
+  uint64_t operator()(const Element<is_unique>& e) const {
+    return static_cast<uint64_t>(static_cast<int64_t>(e.get())) ^ (uint64_t(1) << 63);
+  }
+};
+
+// a quantized key: most comparisons are ties, broken by the elements.
+template<bool is_unique>
+struct CoarseKey {
+  uint64_t operator()(const Element<is_unique>& e) const {
+    return e.get() / 100;
+  }
+};
+
+TEST(DHeapTest, Sort) {
+  DHeap<Element<false>, ElementKey<false>, 2> binary;
+  EXPECT_EQ(SortMismatch<false>(binary, 1000), "");
+  DHeap<Element<false>, ElementKey<false>, 4> quaternary;
+  EXPECT_EQ(SortMismatch<false>(quaternary, 1000), "");
+  DHeap<Element<false>, ElementKey<false>, 8> octonary;
+  EXPECT_EQ(SortMismatch<false>(octonary, 1000), "");
+  DHeap<Element<false>, ElementKey<false>, 3> few;
+  EXPECT_EQ(SortMismatch<false>(few, 7), "");
+  DHeap<Element<true>, ElementKey<true>, 8> unique;
+  EXPECT_EQ(SortMismatch<true>(unique, 1000), "");
+}
+
+TEST(DHeapTest, QuantizedKey) {
+  DHeap<Element<false>, CoarseKey<false>, 4> h;
+  EXPECT_EQ(SortMismatch<false>(h, 1000), "");
+  DHeap<Element<true>, CoarseKey<true>, 8> unique;
+  EXPECT_EQ(SortMismatch<true>(unique, 1000), "");
+}
+
+TEST(DHeapTest, KeysAlignedToCacheLine) {
+  DHeap<Element<false>, ElementKey<false>, 8> h;
+  for (int i = 0; i < 100; ++i) {
+    h.push(Element<false>{i});
+  }
+  // the children of a node start on a cache line.
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(&h.key(h.first_child(3))) % 64, 0);
+}
+
+struct TrackedKey {
+  uint64_t operator()(const Tracked& t) const {
+    return t.key >> 4;
+  }
+};
+
+// the NHIC/NHER contract GDHeap rely on, with the key array moving along with the elements.
+TEST(DHeapTest, IndexNotification) {
+  std::map<int, size_t> index;
+  DHeap<Tracked, TrackedKey, 4, std::less<Tracked>, TrackIndex<Tracked>, TrackRemove<Tracked>> h(
+    std::less<Tracked>(), TrackIndex<Tracked>{&index}, TrackRemove<Tracked>{&index});
+  std::default_random_engine re(0);
+  std::uniform_int_distribution<int> dist(0, 1 << 12);
+  auto check = [&]() {
+    ASSERT_EQ(index.size(), h.size());
+    for (const auto& [id, idx] : index) {
+      ASSERT_TRUE(h.has_value(idx));
+      EXPECT_EQ(h[idx].id, id);
+      EXPECT_EQ(h.key(idx), TrackedKey()(h[idx]));
+      if (idx != 0) {
+        EXPECT_FALSE(h[idx] < h[h.parent(idx)]);
+      }
+    }
+  };
+  int next_id = 0;
+  for (size_t round = 0; round < 2000; ++round) {
+    switch (dist(re) % 4) {
+    case 0:
+    case 1:
+      h.push(Tracked{next_id++, dist(re)});
+      break;
+    case 2:
+      if (!h.empty()) {
+        h.remove(dist(re) % h.size());
+      }
+      break;
+    case 3:
+      if (!h.empty()) {
+        size_t idx = dist(re) % h.size();
+        h[idx].key = dist(re);
+        h.rebalance(idx, false);
+      }
+      break;
+    }
+    check();
+  }
+}
+
+constexpr ZombieConfig dary_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_book_heap(BookHeap::DAry, 4);
+
+namespace DAryBook {
+  IMPORT_ZOMBIE(dary_cfg)
+}
+
+TEST(DHeapTest, Book) {
+  using namespace DAryBook;
+  auto& t = Trailokya::get_trailokya();
+  using Book = decltype(t.book);
+  static_assert(std::is_same_v<decltype(t.book.heap),
+                               DHeap<Book::Node, Book::NodeKey, 4, std::less<Book::Node>,
+                                     Book::NHIC_INNER, Book::NHER_INNER>>);
+  constexpr size_t length = 1000;
+  size_t work_done = 0;
+  std::vector<Zombie<int>> zs = {Zombie<int>(0)};
+  for (size_t i = 1; i < length; ++i) {
+    zs.push_back(bindZombie([&](int x) {
+      ++work_done;
+      return Zombie<int>(x + 1);
+    }, zs.back()));
+  }
+  for (size_t i = 0; i < length; i += 3) {
+    zs[i].get_value();
+  }
+  while (!t.reaper.have_soul()) {
+    t.reaper.murder();
+  }
+  for (size_t i = length; i-- > 0;) {
+    EXPECT_EQ(zs[i].get_value(), i);
+  }
+  EXPECT_GT(work_done, length - 1);
+}
+
+struct IgnoreIndex {
+  void operator()(const int&, size_t) { }
+};
+
+struct IgnoreRemoved {
+  void operator()(const int&) { }
+};
+
+TEST(DHeapTest, NodeKeyPreserveOrder) {
+  using Book = GDHeap<dary_cfg, int, IgnoreIndex, IgnoreRemoved>;
+  std::vector<cost_t> costs = {std::numeric_limits<cost_t>::min(), -(cost_t(1) << 80), std::numeric_limits<int64_t>::min(),
+                               -1, 0, 1, std::numeric_limits<int64_t>::max(), cost_t(1) << 80};
+  for (size_t i = 0; i + 1 < costs.size(); ++i) {
+    EXPECT_LE(Book::NodeKey()(Book::Node(0, costs[i], 0)), Book::NodeKey()(Book::Node(0, costs[i + 1], 0)));
+  }
+  EXPECT_LT(Book::NodeKey()(Book::Node(0, -1, 0)), Book::NodeKey()(Book::Node(0, 0, 0)));
+  EXPECT_LT(Book::NodeKey()(Book::Node(0, 0, 5)), Book::NodeKey()(Book::Node(0, 3, 3)));
+}
@@ -0,0 +1,62 @@
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "zombie/ffi.hpp"
+
+// through the zombie_ffi shared library.
+TEST(FfiTest, AffFunction) {
+  AffFunction* f = aff_function_new(2, 1);
+  AffFunction* g = aff_function_new(1, 5);
+  EXPECT_EQ(aff_function_eval(f, 3), 7);
+  aff_t* until = aff_function_lt_until(f, g);
+  ASSERT_NE(until, nullptr);
+  EXPECT_EQ(*until, 4);
+  until = aff_function_le_until(f, g);
+  ASSERT_NE(until, nullptr);
+  EXPECT_EQ(*until, 5);
+  EXPECT_EQ(aff_function_le_until(g, f), nullptr);
+  aff_function_delete(f);
+  aff_function_delete(g);
+}
+
+TEST(FfiTest, KineticHanger) {
+  int a = 0, b = 1;
+  KineticHanger* hanger = kinetic_hanger_new(0);
+  EXPECT_TRUE(kinetic_hanger_empty(hanger));
+  AffFunction* rising = aff_function_new(1, 0);
+  AffFunction* falling = aff_function_new(-1, 10);
+  kinetic_hanger_push(hanger, &a, rising);
+  kinetic_hanger_push(hanger, &b, falling);
+  EXPECT_EQ(kinetic_hanger_size(hanger), 2);
+  EXPECT_EQ(kinetic_hanger_peek(hanger), &a);
+  EXPECT_EQ(kinetic_hanger_cur_min_value(hanger), 0);
+  kinetic_hanger_advance_to(hanger, 6);
+  EXPECT_EQ(kinetic_hanger_time(hanger), 6);
+  EXPECT_EQ(kinetic_hanger_peek(hanger), &b);
+  EXPECT_EQ(kinetic_hanger_cur_min_value(hanger), 4);
+  EXPECT_EQ(kinetic_hanger_index(hanger, 1), &a);
+  EXPECT_EQ(kinetic_hanger_remove(hanger, 1), &a);
+  EXPECT_EQ(kinetic_hanger_pop(hanger), &b);
+  EXPECT_TRUE(kinetic_hanger_empty(hanger));
+  kinetic_hanger_delete(hanger);
+  aff_function_delete(rising);
+  aff_function_delete(falling);
+}
+
+TEST(FfiTest, Heap) {
+  std::vector<int> elms = {0, 1, 2, 3};
+  std::vector<double> scores = {2.5, -1, 7, 0};
+  Heap* heap = heap_new();
+  for (size_t i = 0; i < elms.size(); ++i) {
+    heap_push(heap, &elms[i], scores[i]);
+  }
+  EXPECT_EQ(heap_size(heap), 4);
+  EXPECT_EQ(heap_peek_score(heap), -1);
+  EXPECT_EQ(heap_peek(heap), &elms[1]);
+  EXPECT_EQ(heap_pop(heap), &elms[1]);
+  EXPECT_EQ(heap_pop(heap), &elms[3]);
+  EXPECT_EQ(heap_pop(heap), &elms[0]);
+  EXPECT_EQ(heap_pop(heap), &elms[2]);
+  EXPECT_TRUE(heap_empty(heap));
+  heap_delete(heap);
+}
@@ -0,0 +1,132 @@
+#include <map>
+#include <random>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+// common.hpp define ZOMBIE_KINETIC_VERIFY_INVARIANT, so every operation below check the heap and it's certificates.
+#include "common.hpp"
+#include "zombie/heap/kinetic.hpp"
+
+TEST(AffFunctionTest, Eval) {
+  AffFunction f(3, -7);
+  EXPECT_EQ(f(0), -7);
+  EXPECT_EQ(f(5), 8);
+  EXPECT_EQ(AffFunction(0, 4)(1000), 4);
+  // saturate instead of overflowing.
+  EXPECT_EQ(AffFunction(std::numeric_limits<slope_t>::max(), 0)(2), std::numeric_limits<aff_t>::max());
+  EXPECT_EQ(AffFunction(std::numeric_limits<slope_t>::max(), 0)(-2), std::numeric_limits<aff_t>::min());
+}
+
+TEST(AffFunctionTest, UntilAgainstBruteForce) {
+  std::default_random_engine re(0);
+  std::uniform_int_distribution<int64_t> slope(-5, 5), shift(-50, 50);
+  for (size_t round = 0; round < 2000; ++round) {
+    AffFunction f(slope(re), shift(re)), g(slope(re), shift(re));
+    for (bool strict : {true, false}) {
+      auto holds = [&](int64_t x) { return strict ? f(x) < g(x) : f(x) <= g(x); };
+      std::optional<shift_t> until = strict ? f.lt_until(g) : f.le_until(g);
+      for (int64_t x = -200; x <= 200; ++x) {
+        if (holds(x)) {
+          // from here on it hold exactly until [until].
+          for (int64_t y = x; y <= 200; ++y) {
+            EXPECT_EQ(holds(y), !until.has_value() || y < until.value()) << x << " " << y;
+          }
+          break;
+        }
+      }
+    }
+  }
+}
+
+TEST(AffFunctionTest, UntilDoNotOverflow) {
+  AffFunction f(std::numeric_limits<slope_t>::max(), 0), g(std::numeric_limits<slope_t>::min(), 0);
+  EXPECT_EQ(f.le_until(g), 1);
+  EXPECT_EQ(f.lt_until(g), 0);
+  EXPECT_EQ(g.le_until(f), std::nullopt);
+}
+
+struct KineticElement {
+  int id;
+};
+
+struct KineticIndex {
+  std::map<int, size_t>* index;
+  void operator()(const KineticElement& e, size_t idx) {
+    (*index)[e.id] = idx;
+  }
+};
+
+struct KineticRemoved {
+  std::map<int, size_t>* index;
+  void operator()(const KineticElement& e) {
+    index->erase(e.id);
+  }
+};
+
+TEST(KineticMinHeapTest, AgainstBruteForce) {
+  std::map<int, size_t> index;
+  std::map<int, AffFunction> functions;
+  KineticMinHeap<KineticElement, KineticIndex, KineticRemoved> h(-100, KineticIndex{&index}, KineticRemoved{&index});
+  std::default_random_engine re(0);
+  std::uniform_int_distribution<int64_t> slope(-10, 10), shift(-1000, 1000), step(0, 30);
+  auto check = [&]() {
+    ASSERT_EQ(h.size(), functions.size());
+    ASSERT_EQ(index.size(), functions.size());
+    for (const auto& [id, idx] : index) {
+      ASSERT_EQ(h[idx].id, id);
+      EXPECT_EQ(h.function(idx), functions.at(id));
+    }
+    if (!h.empty()) {
+      aff_t min = std::numeric_limits<aff_t>::max();
+      for (const auto& [id, f] : functions) {
+        min = std::min(min, f(h.time()));
+      }
+      EXPECT_EQ(h.cur_min_value(), min);
+    }
+  };
+  int next_id = 0;
+  for (size_t round = 0; round < 3000; ++round) {
+    switch (step(re) % 5) {
+    case 0:
+    case 1: {
+      AffFunction f(slope(re), shift(re));
+      functions.emplace(next_id, f);
+      h.push(KineticElement{next_id++}, f);
+      break;
+    }
+    case 2:
+      h.advance_to(h.time() + step(re));
+      break;
+    case 3:
+      if (!h.empty()) {
+        functions.erase(h.pop().id);
+      }
+      break;
+    case 4:
+      if (!h.empty()) {
+        functions.erase(h.remove(step(re) % h.size()).id);
+      }
+      break;
+    }
+    check();
+  }
+}
+
+TEST(KineticMinHeapTest, LongJump) {
+  // all the crossings happen in one advance_to, several at the same time.
+  KineticMinHeap<Element<false>> h(0);
+  std::vector<aff_t> expected;
+  for (int i = 0; i < 200; ++i) {
+    AffFunction f(i % 7 - 3, (i * 37) % 101);
+    h.push(Element<false>{i}, f);
+    expected.push_back(f(1000000));
+  }
+  h.advance_to(1000000);
+  std::vector<aff_t> values;
+  while (!h.empty()) {
+    values.push_back(h.cur_min_value());
+    h.pop();
+  }
+  std::sort(expected.begin(), expected.end());
+  EXPECT_EQ(values, expected);
+}
@@ -0,0 +1,139 @@
+#include <map>
+#include <random>
+#include <gtest/gtest.h>
+
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+// the smallest pages, so keys spread over many pages.
+using SmallPages = PageList<int, int, 6>;
+
+TEST(PageListTest, Empty) {
+  SmallPages index;
+  EXPECT_FALSE(index.has_le(0));
+  EXPECT_FALSE(index.has_le(1000));
+  EXPECT_EQ(index.find_precise(0), nullptr);
+  index.remove_precise(0);
+  EXPECT_EQ(index.size, 0);
+}
+
+TEST(PageListTest, ReclaimPages) {
+  SmallPages index;
+  std::map<int, int> m;
+  for (int i = 0; i < 10000; i += 3) {
+    index.insert(i, i);
+    m[i] = i;
+  }
+  EXPECT_EQ(index.page_count, 10000 / 64 + 1);
+  // drop a whole range in the middle: its pages are freed, lookups skip over them.
+  for (int i = 0; i < 10000; i += 3) {
+    if (1000 <= i && i < 9000) {
+      index.remove_precise(i);
+      m.erase(i);
+    }
+  }
+  EXPECT_LT(index.page_count, 2000 / 64 + 3);
+  EXPECT_EQ(IndexMismatch(index, m), "");
+  for (int k = 0; k < 10100; k += 7) {
+    EXPECT_EQ(FindLeMismatch(index, m, k), "");
+  }
+  for (const auto& [k, v] : std::map<int, int>(m)) {
+    index.remove_precise(k);
+  }
+  EXPECT_EQ(index.size, 0);
+  EXPECT_EQ(index.page_count, 0);
+  EXPECT_TRUE(index.pages.empty());
+  EXPECT_FALSE(index.has_le(100000));
+}
+
+TEST(PageListTest, DirectoryFollowLiveKeys) {
+  SmallPages index;
+  std::map<int, int> m;
+  constexpr int window = 1000;
+  size_t max_pages = 0;
+  // a window of live keys sliding up, as tocks do in a long running process.
+  for (int i = 0; i < 1000000; ++i) {
+    index.insert(i, i);
+    if (i >= window) {
+      index.remove_precise(i - window);
+    }
+    max_pages = std::max(max_pages, index.pages.size());
+  }
+  for (int i = 1000000 - window; i < 1000000; ++i) {
+    m[i] = i;
+  }
+  // the live keys span a word or two of the directory, which is at most 4 times that.
+  EXPECT_LE(max_pages, 16 * 64);
+  EXPECT_EQ(IndexMismatch(index, m), "");
+  // keys below the directory grow it at the front, and removing them rebase it again.
+  index.insert(5, 5);
+  m[5] = 5;
+  EXPECT_EQ(IndexMismatch(index, m), "");
+  EXPECT_EQ(FindLeMismatch(index, m, 4), "");
+  EXPECT_EQ(FindLeMismatch(index, m, 500000), "");
+  index.remove_precise(5);
+  m.erase(5);
+  EXPECT_EQ(IndexMismatch(index, m), "");
+  EXPECT_LE(index.pages.size(), 16 * 64);
+}
+
+TEST(PageListTest, RandomAgainstMap) {
+  std::default_random_engine rng(42);
+  std::uniform_int_distribution<int> key(0, 5000);
+  std::uniform_int_distribution<int> op(0, 9);
+  SmallPages index;
+  std::map<int, int> m;
+  for (int i = 0; i < 20000; ++i) {
+    int k = key(rng);
+    int o = op(rng);
+    if (o < 5) {
+      index.insert(k, i);
+      m[k] = i;
+    } else if (o < 8) {
+      index.remove_precise(k);
+      m.erase(k);
+    } else if (o < 9) {
+      index.remove_le(k);
+      auto it = m.upper_bound(k);
+      if (it != m.begin()) {
+        m.erase(--it);
+      }
+    } else {
+      EXPECT_EQ(FindLeMismatch(index, m, k), "");
+      EXPECT_EQ(index.has_precise(k), m.count(k) == 1);
+    }
+    if (i % 1000 == 0) {
+      EXPECT_EQ(IndexMismatch(index, m), "");
+    }
+  }
+  EXPECT_EQ(IndexMismatch(index, m), "");
+}
+
+constexpr ZombieConfig page_table_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_akasha(AkashaIndex::PageTable);
+
+namespace PageTableAkasha {
+  IMPORT_ZOMBIE(page_table_cfg)
+}
+
+TEST(PageListTest, Akasha) {
+  using namespace PageTableAkasha;
+  static_assert(std::is_same_v<Trailokya::Akasha, PageList<Tock, ZombieInternal::Context<page_table_cfg>>>);
+  auto& t = Trailokya::get_trailokya();
+  constexpr size_t length = 1000;
+  size_t work_done = 0;
+  std::vector<Zombie<int>> zs = {Zombie<int>(0)};
+  for (size_t i = 1; i < length; ++i) {
+    zs.push_back(bindZombie([&](int x) {
+      ++work_done;
+      return Zombie<int>(x + 1);
+    }, zs.back()));
+  }
+  while (!t.reaper.have_soul()) {
+    t.reaper.murder();
+  }
+  for (size_t i = length; i-- > 0;) {
+    EXPECT_EQ(zs[i].get_value(), i);
+  }
+  EXPECT_GT(work_done, length - 1);
+}
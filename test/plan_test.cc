@@ -0,0 +1,161 @@
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+#include <gtest/gtest.h>
+
+constexpr ZombieConfig plan_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1});
+
+namespace Plan {
+  IMPORT_ZOMBIE(plan_cfg)
+}
+
+using namespace Plan;
+
+void EvictAll() {
+  Trailokya::get_trailokya().reaper.evict_while([]() { return true; });
+}
+
+TEST(PlanTest, NothingToDo) {
+  Zombie<int> a(1);
+  Zombie<int> b = bindZombie([](int x) { return Zombie<int>(x + 1); }, a);
+  auto plan = ZombieInternal::plan_recompute<plan_cfg>({a.z, b.z});
+  EXPECT_TRUE(plan.empty());
+  auto values = plan.execute();
+  ASSERT_EQ(values.size(), 2);
+  EXPECT_EQ((std::dynamic_pointer_cast<ZombieInternal::ZombieNode<plan_cfg, int>>(values[1])->get_ref()), 2);
+}
+
+// the diamond b <- a, c <- b, d <- b, all evicted.
+// the replay of c evict all it can, as if it ran out of memory.
+template<typename F>
+size_t DiamondUnderPressure(const F& recompute) {
+  bool pressure = false;
+  size_t executed = 0;
+  Zombie<int> a(1);
+  Zombie<int> b = bindZombie([&](int x) { ++executed; return Zombie<int>(x * 2); }, a);
+  Zombie<int> c = bindZombie([&](int x) {
+    if (pressure) {
+      EvictAll();
+    }
+    return Zombie<int>(x + 1);
+  }, b);
+  Zombie<int> d = bindZombie([](int x) { return Zombie<int>(x + 2); }, b);
+  EvictAll();
+  EXPECT_TRUE(b.evicted());
+  EXPECT_TRUE(c.evicted());
+  EXPECT_TRUE(d.evicted());
+  pressure = true;
+  executed = 0;
+  recompute(b, c, d);
+  pressure = false;
+  return executed;
+}
+
+TEST(PlanTest, Diamond) {
+  // b, evicted during the replay of c, is replayed again for d.
+  size_t unplanned = DiamondUnderPressure([](const auto& b, const auto& c, const auto& d) {
+    EXPECT_EQ(c.get_value(), 3);
+    EXPECT_EQ(d.get_value(), 4);
+  });
+  EXPECT_EQ(unplanned, 2);
+  size_t planned = DiamondUnderPressure([](const auto& b, const auto& c, const auto& d) {
+    auto plan = ZombieInternal::plan_recompute<plan_cfg>({c.z, d.z});
+    // b, then c and d reading it.
+    EXPECT_EQ(plan.steps.size(), 3);
+    EXPECT_EQ(plan.steps[0].values[0].created_time, b.z.created_time);
+    EXPECT_TRUE(plan.steps[0].inputs.empty());
+    EXPECT_EQ(plan.steps[0].last_use, 2);
+    EXPECT_EQ(plan.steps[1].inputs, std::vector<size_t>{0});
+    EXPECT_EQ(plan.steps[2].inputs, std::vector<size_t>{0});
+    EXPECT_GT(plan.estimated_time().count(), 0);
+    auto values = plan.execute();
+    EXPECT_EQ((std::dynamic_pointer_cast<ZombieInternal::ZombieNode<plan_cfg, int>>(values[0])->get_ref()), 3);
+    EXPECT_EQ((std::dynamic_pointer_cast<ZombieInternal::ZombieNode<plan_cfg, int>>(values[1])->get_ref()), 4);
+    // nothing is left pinned.
+    EXPECT_TRUE(Trailokya::get_trailokya().pinned_tocks.empty());
+  });
+  EXPECT_EQ(planned, 1);
+}
+
+TEST(PlanTest, OneReplayPerContext) {
+  Zombie<int> a(1);
+  Zombie<int> b = bindZombie([](int x) { return Zombie<int>(x + 1); }, a);
+  EvictAll();
+  auto plan = ZombieInternal::plan_recompute<plan_cfg>({b.z, b.z});
+  ASSERT_EQ(plan.steps.size(), 1);
+  EXPECT_EQ(plan.steps[0].values.size(), 2);
+  auto& t = Trailokya::get_trailokya();
+  size_t replays = t.stats().replays;
+  plan.execute();
+  EXPECT_EQ(t.stats().replays, replays + 1);
+}
+
+constexpr ZombieConfig plan_watermark_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1})
+  .with_watermarks(/*high=*/1 << 16, /*low=*/0);
+
+namespace PlanWatermark {
+  IMPORT_ZOMBIE(plan_watermark_cfg)
+}
+
+TEST(PlanTest, ReclaimWhilePinned) {
+  struct Test {};
+  using Resource = Resource<Test>;
+  size_t executed = 0;
+  PlanWatermark::Zombie<Resource> a(0);
+  PlanWatermark::Zombie<Resource> b = PlanWatermark::bindZombie([&](const Resource& x) { ++executed; return PlanWatermark::Zombie<Resource>(x.value + 1); }, a);
+  PlanWatermark::Zombie<Resource> c = PlanWatermark::bindZombie([](const Resource& x) { return PlanWatermark::Zombie<Resource>(x.value + 1); }, b);
+  PlanWatermark::Zombie<Resource> d = PlanWatermark::bindZombie([](const Resource& x) { return PlanWatermark::Zombie<Resource>(x.value + 2); }, b);
+  // the reclaimer run down to the low watermark between every step.
+  EXPECT_TRUE(b.evicted());
+  EXPECT_TRUE(c.evicted());
+  executed = 0;
+  auto plan = ZombieInternal::plan_recompute<plan_watermark_cfg>({c.z, d.z});
+  // between the steps, the only context left to evict is b's, which is pinned: the reclaimer must give up on it.
+  auto values = plan.execute();
+  EXPECT_EQ((std::dynamic_pointer_cast<ZombieInternal::ZombieNode<plan_watermark_cfg, Resource>>(values[0])->get_ref().value), 2);
+  EXPECT_EQ((std::dynamic_pointer_cast<ZombieInternal::ZombieNode<plan_watermark_cfg, Resource>>(values[1])->get_ref().value), 3);
+  EXPECT_EQ(executed, 1);
+  EXPECT_GT(PlanWatermark::Trailokya::get_trailokya().reclaimer.background_runs, 0);
+}
+
+// b, at the end of a chain from a, and e, read from a, are both read by c and d, and only one of them fit in the pin budget:
+// b, which would take the whole chain to recompute, is kept. e is evicted by the replay of c, and recomputed for d.
+TEST(PlanTest, KeepExpensiveWithinBudget) {
+  struct Test {};
+  using Resource = Resource<Test>;
+  bool pressure = false;
+  size_t b_executed = 0, e_executed = 0;
+  Zombie<Resource> a(0);
+  Zombie<Resource> b0 = bindZombie([](const Resource& x) { return Zombie<Resource>(x.value + 1); }, a);
+  Zombie<Resource> b = bindZombie([&](const Resource& x) { ++b_executed; return Zombie<Resource>(x.value + 1); }, b0);
+  Zombie<Resource> e = bindZombie([&](const Resource& x) { ++e_executed; return Zombie<Resource>(x.value + 1); }, a);
+  auto read = [&](const Resource& x, const Resource& y) {
+    if (pressure) {
+      EvictAll();
+    }
+    return Zombie<Resource>(x.value + y.value);
+  };
+  Zombie<Resource> c = bindZombie(read, b, e);
+  Zombie<Resource> d = bindZombie(read, b, e);
+  EvictAll();
+  EXPECT_TRUE(b.evicted());
+  EXPECT_TRUE(e.evicted());
+  auto plan = ZombieInternal::plan_recompute<plan_cfg>({c.z, d.z});
+  // b0, b, e, c, d.
+  ASSERT_EQ(plan.steps.size(), 5);
+  EXPECT_EQ(plan.steps[1].values[0].created_time, b.z.created_time);
+  EXPECT_EQ(plan.steps[2].values[0].created_time, e.z.created_time);
+  EXPECT_GT(plan.steps[1].recompute_time, plan.steps[2].recompute_time);
+  plan.pin_budget = GetSize<Resource>()(Resource(0));
+  pressure = true;
+  b_executed = 0;
+  e_executed = 0;
+  auto values = plan.execute();
+  pressure = false;
+  EXPECT_EQ((std::dynamic_pointer_cast<ZombieInternal::ZombieNode<plan_cfg, Resource>>(values[0])->get_ref().value), 3);
+  EXPECT_EQ((std::dynamic_pointer_cast<ZombieInternal::ZombieNode<plan_cfg, Resource>>(values[1])->get_ref().value), 3);
+  EXPECT_EQ(b_executed, 1);
+  EXPECT_EQ(e_executed, 2);
+  EXPECT_TRUE(Trailokya::get_trailokya().pinned_tocks.empty());
+}
@@ -0,0 +1,182 @@
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+#include <gtest/gtest.h>
+
+constexpr ZombieConfig lru_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::LRU);
+constexpr ZombieConfig lfu_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::LFU);
+constexpr ZombieConfig gd_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::GreedyDual);
+constexpr ZombieConfig gdsf_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::GDSF);
+constexpr ZombieConfig cost_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::Cost);
+
+// [count] values computed from the same input, so they cost the same.
+template<const ZombieConfig& cfg>
+std::vector<ZombieInternal::ExternalZombie<cfg, int>> Siblings(size_t count) {
+  using Z = ZombieInternal::ExternalZombie<cfg, int>;
+  auto& t = ZombieInternal::Trailokya<cfg>::get_trailokya();
+  static Z root(0);
+  std::vector<Z> zs;
+  for (size_t i = 0; i < count; ++i) {
+    zs.push_back(ZombieInternal::bindZombie<cfg>([](int x) { return Z(x + 1); }, root.z));
+    t.meter.fast_forward(1ms);
+  }
+  return zs;
+}
+
+template<const ZombieConfig& cfg>
+size_t Victim(const std::vector<ZombieInternal::ExternalZombie<cfg, int>>& zs) {
+  auto& t = ZombieInternal::Trailokya<cfg>::get_trailokya();
+  std::vector<bool> before;
+  for (const auto& z : zs) {
+    before.push_back(z.evicted());
+  }
+  t.reaper.murder();
+  for (size_t i = 0; i < zs.size(); ++i) {
+    if (!before[i] && zs[i].evicted()) {
+      return i;
+    }
+  }
+  return zs.size();
+}
+
+TEST(PolicyTest, LRU) {
+  auto& t = ZombieInternal::Trailokya<lru_cfg>::get_trailokya();
+  auto zs = Siblings<lru_cfg>(5);
+  for (size_t i : {2, 0, 4, 1, 3}) {
+    EXPECT_EQ(zs[i].get_value(), 1);
+    t.meter.fast_forward(1ms);
+  }
+  EXPECT_EQ(Victim(zs), 2);
+  EXPECT_EQ(Victim(zs), 0);
+  EXPECT_EQ(Victim(zs), 4);
+  // the order only need to be right when an entry reach the top: touching is free.
+  EXPECT_GT(t.stats().adjust_pop_repushes, 0);
+}
+
+TEST(PolicyTest, LFU) {
+  auto zs = Siblings<lfu_cfg>(3);
+  for (size_t i = 0; i < 5; ++i) {
+    zs[0].get_value();
+  }
+  for (size_t i = 0; i < 3; ++i) {
+    zs[1].get_value();
+  }
+  EXPECT_EQ(Victim(zs), 2);
+  EXPECT_EQ(Victim(zs), 1);
+  EXPECT_EQ(Victim(zs), 0);
+}
+
+TEST(PolicyTest, DeferredAccess) {
+  using Buffer = ZombieInternal::Trailokya<lfu_cfg>::AccessBuffer;
+  auto& t = ZombieInternal::Trailokya<lfu_cfg>::get_trailokya();
+  auto zs = Siblings<lfu_cfg>(3);
+  t.drain_access_buffer();
+  auto* ctx = dynamic_cast<ZombieInternal::FullContextNode<lfu_cfg>*>(zs[1].z.ptr().lock()->get_context().get());
+  ASSERT_NE(ctx, nullptr);
+  size_t count = ctx->access_count;
+  for (size_t i = 0; i < 10; ++i) {
+    zs[1].get_value();
+  }
+  zs[2].get_value();
+  // back to back hits fold into one entry, and nothing is applied yet.
+  EXPECT_EQ(t.access_buffer().accesses.size(), 2);
+  EXPECT_EQ(t.access_buffer().accesses[0].count, 10);
+  EXPECT_EQ(ctx->access_count, count);
+  // the eviction decision see every access.
+  EXPECT_EQ(Victim(zs), 0);
+  EXPECT_TRUE(t.access_buffer().accesses.empty());
+  EXPECT_EQ(ctx->access_count, count + 10);
+  // a full buffer is applied on the spot.
+  for (size_t i = 0; i < Buffer::capacity; ++i) {
+    zs[1 + i % 2].get_value();
+  }
+  EXPECT_TRUE(t.access_buffer().accesses.empty());
+  EXPECT_EQ(ctx->access_count, count + 10 + Buffer::capacity / 2);
+}
+
+TEST(PolicyTest, DeferredAccessToReplacedContext) {
+  using Z = ZombieInternal::ExternalZombie<lfu_cfg, int>;
+  auto& t = ZombieInternal::Trailokya<lfu_cfg>::get_trailokya();
+  t.drain_access_buffer();
+  std::vector<Z> zs;
+  zs.push_back(Z(0));
+  for (size_t i = 1; i < 5; ++i) {
+    zs.push_back(ZombieInternal::bindZombie<lfu_cfg>([](int x) { return Z(x + 1); }, zs.back().z));
+  }
+  for (const auto& z : zs) {
+    z.get_value();
+  }
+  // the replay of zs[3] replace it's context in akasha, with accesses to the old one still buffered.
+  zs[3].evict();
+  EXPECT_EQ(zs[3].get_value(), 3);
+  EXPECT_EQ(zs[1].get_value(), 1);
+  // every entry still pointing at a context point at the one in akasha.
+  for (const auto& access : t.access_buffer().accesses) {
+    if (access.context != nullptr) {
+      EXPECT_EQ(access.context, t.akasha.find_le_node(access.tock)->v.get());
+    }
+  }
+  t.drain_access_buffer();
+  EXPECT_TRUE(t.access_buffer().accesses.empty());
+}
+
+TEST(PolicyTest, GreedyDualInflateL) {
+  auto& t = ZombieInternal::Trailokya<gd_cfg>::get_trailokya();
+  auto zs = Siblings<gd_cfg>(5);
+  EXPECT_EQ(t.book.L, 0);
+  t.reaper.murder();
+  cost_t L = t.book.L;
+  EXPECT_GT(L, 0);
+  t.reaper.murder();
+  EXPECT_GE(t.book.L, L);
+  // an access re-base the entry on the current L, ahead of the untouched ones.
+  for (const auto& z : zs) {
+    if (!z.evicted()) {
+      z.get_value();
+      break;
+    }
+  }
+  size_t touched = 0;
+  while (zs[touched].evicted()) {
+    ++touched;
+  }
+  EXPECT_NE(Victim(zs), touched);
+}
+
+TEST(PolicyTest, ChooseVictim) {
+  std::vector<cost_t> priority = {7, 3, 5, 3};
+  cost_t L = 1;
+  EXPECT_EQ(BookPolicy<EvictionPolicy::GreedyDual>::choose_victim(L, priority.data(), priority.size()), 1);
+  EXPECT_EQ(L, 3);
+  // without aging L stay where it is.
+  EXPECT_EQ(BookPolicy<EvictionPolicy::LRU>::choose_victim(L, priority.data(), 3), 1);
+  EXPECT_EQ(L, 3);
+  EXPECT_EQ(BookPolicy<EvictionPolicy::GDSF>::choose_victim(L, priority.data(), 1), 0);
+  EXPECT_EQ(L, 7);
+}
+
+TEST(PolicyTest, GDSFKeepFrequent) {
+  auto& t = ZombieInternal::Trailokya<gdsf_cfg>::get_trailokya();
+  auto zs = Siblings<gdsf_cfg>(4);
+  for (size_t i = 0; i < 10; ++i) {
+    zs[1].get_value();
+  }
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_NE(Victim(zs), 1);
+  }
+  EXPECT_FALSE(zs[1].evicted());
+  EXPECT_GT(t.book.L, 0);
+}
+
+TEST(PolicyTest, ForwardBackward) {
+  EXPECT_EQ(ForwardBackward<cost_cfg>(100, 1ms).wrong, 0);
+  EXPECT_EQ(ForwardBackward<gd_cfg>(100, 1ms).wrong, 0);
+  EXPECT_EQ(ForwardBackward<gdsf_cfg>(100, 1ms).wrong, 0);
+  EXPECT_EQ(ForwardBackward<lru_cfg>(100, 1ms).wrong, 0);
+  EXPECT_EQ(ForwardBackward<lfu_cfg>(100, 1ms).wrong, 0);
+}
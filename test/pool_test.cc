@@ -0,0 +1,106 @@
+#include <set>
+#include <gtest/gtest.h>
+
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+TEST(PoolTest, SlabReuse) {
+  SlabPool pool(24);
+  EXPECT_EQ(pool.object_size % SlabPool::alignment, 0);
+  std::set<void*> first;
+  for (size_t i = 0; i < 3 * pool.objects_per_slab; ++i) {
+    void* p = pool.allocate();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % SlabPool::alignment, 0);
+    EXPECT_TRUE(first.insert(p).second);
+  }
+  EXPECT_EQ(pool.slabs.size(), 3);
+  EXPECT_EQ(pool.live, 3 * pool.objects_per_slab);
+  for (void* p : first) {
+    pool.deallocate(p);
+  }
+  EXPECT_EQ(pool.live, 0);
+  // freed objects are handed out again, without new slabs.
+  std::vector<void*> second;
+  for (size_t i = 0; i < 3 * pool.objects_per_slab; ++i) {
+    second.push_back(pool.allocate());
+    EXPECT_EQ(first.count(second.back()), 1);
+  }
+  EXPECT_EQ(pool.slabs.size(), 3);
+  for (void* p : second) {
+    pool.deallocate(p);
+  }
+}
+
+TEST(PoolTest, ArenaOutliveRelease) {
+  SlabArena* arena = new SlabArena();
+  auto p = std::allocate_shared<std::pair<int, double>>(ArenaAllocator<int>(arena), 1, 2.0);
+  std::weak_ptr<std::pair<int, double>> w = p;
+  EXPECT_EQ(arena->live, 1);
+  EXPECT_GT(arena->reserved_bytes(), 0);
+  // still in use: the arena stays until the last object is gone.
+  arena->release();
+  p.reset();
+  EXPECT_TRUE(w.expired());
+  // the control block, held by w, is the last object: deallocating it free the arena.
+}
+
+TEST(PoolTest, PooledSplayList) {
+  SplayList<int, int, true> pooled;
+  for (int i = 0; i < 1000; ++i) {
+    pooled.insert(i, i);
+  }
+  EXPECT_EQ(pooled.node_pool.live, 1000);
+  for (int i = 0; i < 1000; i += 2) {
+    pooled.remove_precise(i);
+  }
+  EXPECT_EQ(pooled.node_pool.live, 500);
+  size_t slabs = pooled.node_pool.slabs.size();
+  for (int i = 0; i < 1000; i += 2) {
+    pooled.insert(i, i);
+  }
+  EXPECT_EQ(pooled.node_pool.slabs.size(), slabs);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(*pooled.find_precise(i), i);
+  }
+}
+
+constexpr ZombieConfig pooled_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_pool_allocation(true);
+constexpr ZombieConfig unpooled_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_pool_allocation(false);
+
+namespace Pooled {
+  IMPORT_ZOMBIE(pooled_cfg)
+}
+
+namespace Unpooled {
+  IMPORT_ZOMBIE(unpooled_cfg)
+}
+
+template<typename Z, typename F, typename T>
+size_t Chain(const F& bind, T& t) {
+  std::vector<Z> zs = {Z(0)};
+  for (size_t i = 1; i < 100; ++i) {
+    zs.push_back(bind([](int x) { return Z(x + 1); }, zs.back()));
+  }
+  while (!t.reaper.have_soul()) {
+    t.reaper.murder();
+  }
+  for (size_t i = zs.size(); i-- > 0;) {
+    EXPECT_EQ(zs[i].get_value(), i);
+  }
+  return t.arena->live;
+}
+
+TEST(PoolTest, Contexts) {
+  {
+    using namespace Pooled;
+    auto& t = Trailokya::get_trailokya();
+    EXPECT_GT((Chain<Zombie<int>>([](auto f, const auto& z) { return bindZombie(f, z); }, t)), 0);
+    EXPECT_GT(t.akasha.node_pool.live, 0);
+  }
+  {
+    using namespace Unpooled;
+    auto& t = Trailokya::get_trailokya();
+    EXPECT_EQ((Chain<Zombie<int>>([](auto f, const auto& z) { return bindZombie(f, z); }, t)), 0);
+    EXPECT_EQ(t.akasha.node_pool.live, 0);
+  }
+}
@@ -0,0 +1,65 @@
+#include <map>
+#include <random>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+constexpr ZombieConfig sampled_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_sampled_book(4);
+constexpr ZombieConfig sampled_lru_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_sampled_book().with_eviction_policy(EvictionPolicy::LRU);
+
+TEST(SampledBookTest, Container) {
+  std::map<int, size_t> index;
+  SampledBook<sampled_cfg, int, TrackIndex<int>, TrackRemove<int>> book(TrackIndex<int>{&index}, TrackRemove<int>{&index});
+  std::vector<int> cost(100);
+  for (int i = 0; i < 100; ++i) {
+    cost[i] = (i * 37) % 100;
+    book.push(int(i), cost[i]);
+  }
+  auto cost_f = [&](const int& i) { return cost_t(cost[i]); };
+  // the best of a sample of 4 is, on average, better than 4 / 5 of the book.
+  double rank = 0;
+  size_t pops = 0;
+  while (book.size() > 4) {
+    int i = book.adjust_pop(cost_f);
+    rank += static_cast<double>(std::count_if(index.begin(), index.end(), [&](const auto& p) { return cost[p.first] > cost[i]; })) / index.size();
+    ++pops;
+    ASSERT_EQ(index.size(), book.size());
+    for (const auto& [id, idx] : index) {
+      EXPECT_EQ(book.arr[idx].t, id);
+    }
+  }
+  EXPECT_GT(rank / pops, 0.7);
+  // once the sample cover the whole book, the order is exact.
+  int last = -1;
+  while (!book.empty()) {
+    int i = book.adjust_pop(cost_f);
+    EXPECT_GT(cost[i], last);
+    last = cost[i];
+  }
+  EXPECT_TRUE(index.empty());
+}
+
+template<const ZombieConfig& cfg>
+void SampledForwardBackward() {
+  auto& t = ZombieInternal::Trailokya<cfg>::get_trailokya();
+  using Trailokya = ZombieInternal::Trailokya<cfg>;
+  static_assert(std::is_same_v<decltype(t.book), SampledBook<cfg, std::unique_ptr<ZombieInternal::Phantom>,
+                                                             typename Trailokya::NotifyIndexChanged,
+                                                             typename Trailokya::NotifyElementRemoved>>);
+  constexpr size_t length = 200;
+  auto chain = ForwardBackward<cfg>(length, 1ms);
+  EXPECT_EQ(chain.wrong, 0);
+  EXPECT_GT(*chain.work_done, length - 1);
+  while (!t.reaper.have_soul()) {
+    t.reaper.murder();
+  }
+  EXPECT_EQ(chain.zs.back().get_value(), length - 1);
+}
+
+TEST(SampledBookTest, ForwardBackward) {
+  SampledForwardBackward<sampled_cfg>();
+  SampledForwardBackward<sampled_lru_cfg>();
+}
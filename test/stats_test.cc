@@ -0,0 +1,158 @@
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+#include <gtest/gtest.h>
+
+constexpr ZombieConfig stats_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1});
+constexpr ZombieConfig shared_stats_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_runtime(RuntimeMode::Shared);
+
+namespace Stats {
+  IMPORT_ZOMBIE(stats_cfg)
+}
+
+namespace SharedStats {
+  IMPORT_ZOMBIE(shared_stats_cfg)
+}
+
+TEST(StatsTest, ResidentAndMetadata) {
+  using namespace Stats;
+  auto& t = Trailokya::get_trailokya();
+  ZombieStats before = t.stats();
+  {
+    Zombie<int> x(1);
+    Zombie<int> y = bindZombie([](int x) { return Zombie<int>(x + 1); }, x);
+    ZombieStats s = t.stats();
+    EXPECT_EQ(s.resident_values, before.resident_values + 2);
+    EXPECT_EQ(s.resident_bytes, before.resident_bytes + 2 * sizeof(int));
+    EXPECT_GT(s.contexts, before.contexts);
+    EXPECT_GT(s.metadata_bytes, before.metadata_bytes);
+    EXPECT_EQ(s.heap_size, t.book.size());
+    y.evict();
+    EXPECT_EQ(t.stats().resident_values, before.resident_values + 1);
+  }
+}
+
+TEST(StatsTest, HitsAndRematerializations) {
+  using namespace Stats;
+  auto& t = Trailokya::get_trailokya();
+  constexpr size_t length = 10;
+  std::vector<Zombie<int>> zs = {Zombie<int>(0)};
+  for (size_t i = 1; i < length; ++i) {
+    zs.push_back(bindZombie([](int x) { return Zombie<int>(x + 1); }, zs.back()));
+  }
+  ZombieStats before = t.stats();
+  EXPECT_EQ(zs.back().get_value(), length - 1);
+  ZombieStats s = t.stats();
+  EXPECT_EQ(s.hits, before.hits + 1);
+  EXPECT_EQ(s.rematerializations, before.rematerializations);
+
+  for (size_t i = 1; i < length; ++i) {
+    zs[i].evict();
+  }
+  EXPECT_EQ(zs.back().get_value(), length - 1);
+  s = t.stats();
+  // the last value, then each input of the replayed contexts down the chain.
+  EXPECT_EQ(s.rematerializations, before.rematerializations + length - 1);
+  EXPECT_EQ(s.replays, before.replays + length - 1);
+  EXPECT_GE(s.max_replay_depth, length - 1);
+  EXPECT_GT(s.recompute_time, before.recompute_time);
+}
+
+TEST(StatsTest, Evictions) {
+  using namespace Stats;
+  auto& t = Trailokya::get_trailokya();
+  Zombie<int> x(1);
+  Zombie<int> y = bindZombie([](int x) { return Zombie<int>(x + 1); }, x);
+  ZombieStats before = t.stats();
+  size_t murdered = 0;
+  while (!y.evicted()) {
+    t.reaper.murder();
+    ++murdered;
+  }
+  ZombieStats s = t.stats();
+  // entries of contexts which are already gone are popped without an eviction.
+  EXPECT_GT(s.evictions, before.evictions);
+  EXPECT_LE(s.evictions, before.evictions + murdered);
+  EXPECT_EQ(s.heap_size, before.heap_size - murdered);
+  EXPECT_GE(s.adjust_pop_repushes, before.adjust_pop_repushes);
+  EXPECT_GE(s.L, before.L);
+}
+
+constexpr ZombieConfig gd_stats_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_eviction_policy(EvictionPolicy::GreedyDual);
+
+// a replay after the values of a context were evicted one by one replace the context,
+// which must take it's entry out of the book with it.
+template<const ZombieConfig& cfg>
+void NoTombstones() {
+  using Z = ZombieInternal::ExternalZombie<cfg, int>;
+  auto& t = ZombieInternal::Trailokya<cfg>::get_trailokya();
+  constexpr size_t length = 10;
+  std::vector<Z> zs = {Z(0)};
+  for (size_t i = 1; i < length; ++i) {
+    zs.push_back(ZombieInternal::bindZombie<cfg>([](int x) { return Z(x + 1); }, zs.back().z));
+  }
+  ZombieStats before = t.stats();
+  for (size_t round = 0; round < 5; ++round) {
+    for (size_t i = 1; i < length; ++i) {
+      EXPECT_EQ(zs[i].get_value(), i);
+      zs[i].evict();
+    }
+    EXPECT_EQ(zs.back().get_value(), length - 1);
+    // the hits buffered before the replay are on the contexts it destroyed.
+    t.drain_access_buffer();
+  }
+  ZombieStats s = t.stats();
+  EXPECT_EQ(s.heap_size, before.heap_size);
+  EXPECT_EQ(s.heap_tombstones, 0);
+  EXPECT_EQ(s.book_entries_removed, before.book_entries_removed + 5 * (length - 1));
+}
+
+TEST(StatsTest, NoTombstones) {
+  // entries still waiting for an index, and entries in the heap.
+  NoTombstones<stats_cfg>();
+  NoTombstones<gd_stats_cfg>();
+}
+
+TEST(StatsTest, SharedLockFreeHits) {
+  using namespace SharedStats;
+  auto& t = Trailokya::get_trailokya();
+  Zombie<int> x(1);
+  Zombie<int> y = bindZombie([](int x) { return Zombie<int>(x + 1); }, x);
+  ZombieStats before = t.stats();
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(y.get_value(), 2);
+  }
+  // counted by this thread, then folded in when stats() take the lock.
+  EXPECT_EQ(t.stats().hits, before.hits + 10);
+}
+
+constexpr ZombieConfig approx_stats_cfg = ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{3, 2});
+
+namespace ApproxStats {
+  IMPORT_ZOMBIE(approx_stats_cfg)
+}
+
+template<const ZombieConfig& cfg>
+ZombieStats ForwardBackwardStats() {
+  EXPECT_EQ(ForwardBackward<cfg>(200).wrong, 0);
+  return ZombieInternal::Trailokya<cfg>::get_trailokya().stats();
+}
+
+TEST(StatsTest, ApproxFactorAvoidRepushes) {
+  using Book = decltype(ApproxStats::Trailokya::get_trailokya().book);
+  EXPECT_TRUE(Book::approx_equal(100, 150));
+  EXPECT_TRUE(Book::approx_equal(150, 100));
+  EXPECT_FALSE(Book::approx_equal(100, 151));
+  EXPECT_FALSE(Book::approx_equal(-1, 1));
+  EXPECT_TRUE(Book::approx_equal(-100, -120));
+  using ExactBook = decltype(Stats::Trailokya::get_trailokya().book);
+  EXPECT_FALSE(ExactBook::approx_equal(100, 101));
+
+  ZombieStats exact = ForwardBackwardStats<stats_cfg>();
+  ZombieStats approx = ForwardBackwardStats<approx_stats_cfg>();
+  EXPECT_EQ(exact.adjust_pop_repushes_avoided, 0);
+  EXPECT_GT(approx.adjust_pop_repushes_avoided, 0);
+  EXPECT_LT(approx.adjust_pop_repushes, exact.adjust_pop_repushes);
+}
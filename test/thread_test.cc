@@ -0,0 +1,154 @@
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+#include <thread>
+#include <gtest/gtest.h>
+
+constexpr ZombieConfig thread_local_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_runtime(RuntimeMode::ThreadLocal);
+
+namespace ThreadLocal {
+  IMPORT_ZOMBIE(thread_local_cfg)
+}
+
+// each thread build a chain, evict it, then walk it backward to force recomputation.
+// returns the number of times the chain functions ran.
+size_t ChainWorker(int seed, size_t length) {
+  using namespace ThreadLocal;
+  auto& t = Trailokya::get_trailokya();
+  size_t work_done = 0;
+  std::vector<Zombie<int>> zs;
+  zs.push_back(Zombie<int>(seed));
+  for (size_t i = 1; i < length; ++i) {
+    zs.push_back(bindZombie([&](int x) {
+      ++work_done;
+      t.meter.fast_forward(1ms);
+      return Zombie<int>(x + 1);
+    }, zs.back()));
+  }
+  for (size_t i = 1; i < length; ++i) {
+    zs[i].evict();
+    EXPECT_TRUE(zs[i].evicted());
+  }
+  for (size_t i = length; i-- > 0;) {
+    EXPECT_EQ(zs[i].get_value(), seed + static_cast<int>(i));
+  }
+  while (!t.reaper.have_soul()) {
+    t.reaper.murder();
+  }
+  EXPECT_EQ(zs[length - 1].get_value(), seed + static_cast<int>(length) - 1);
+  return work_done;
+}
+
+TEST(ThreadLocalTest, IndependentRuntime) {
+  using namespace ThreadLocal;
+  Trailokya* main_t = &Trailokya::get_trailokya();
+  Trailokya* other_t = nullptr;
+  std::thread([&]() { other_t = &Trailokya::get_trailokya(); }).join();
+  EXPECT_NE(main_t, other_t);
+
+  ZombieClock* main_clock = &main_t->meter.clock;
+  ZombieClock* other_clock = nullptr;
+  std::thread([&]() { other_clock = &Trailokya::get_trailokya().meter.clock; }).join();
+  EXPECT_NE(main_clock, other_clock);
+}
+
+TEST(ThreadLocalTest, ConcurrentBindEvictRecompute) {
+  constexpr size_t thread_count = 8;
+  constexpr size_t length = 64;
+  std::vector<size_t> work(thread_count, 0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back([&, i]() {
+      work[i] = ChainWorker(static_cast<int>(i * 1000), length);
+    });
+  }
+  for (std::thread& th : threads) {
+    th.join();
+  }
+  for (size_t i = 0; i < thread_count; ++i) {
+    // every link is computed once, and recomputed at least once after eviction.
+    EXPECT_GE(work[i], 2 * (length - 1));
+  }
+}
+
+TEST(ThreadLocalTest, TockIsPerThread) {
+  using namespace ThreadLocal;
+  Zombie<int> x(0);
+  Tock main_tock = Trailokya::get_trailokya().current_tock;
+  std::thread([&]() {
+    for (int i = 0; i < 100; ++i) {
+      Zombie<int> y(i);
+    }
+  }).join();
+  EXPECT_EQ(Trailokya::get_trailokya().current_tock, main_tock);
+}
+
+constexpr ZombieConfig shared_cfg =
+  ZombieConfig(/*metric=*/&uf_metric, /*approx_factor=*/{1, 1}).with_runtime(RuntimeMode::Shared);
+
+namespace Shared {
+  IMPORT_ZOMBIE(shared_cfg)
+}
+
+TEST(SharedRuntimeTest, HitDoesNotTakeLock) {
+  using namespace Shared;
+  auto& t = Trailokya::get_trailokya();
+  Zombie<int> x(1);
+  Zombie<int> y = bindZombie([](int x) { return Zombie<int>(x + 1); }, x);
+  EXPECT_EQ(y.get_value(), 2);
+  auto guard = t.lock();
+  // the main thread hold the runtime lock, yet other threads can still read resident values.
+  std::thread([&]() {
+    for (size_t i = 0; i < 4 * Trailokya::AccessBuffer::capacity; ++i) {
+      EXPECT_EQ(y.get_value(), 2);
+    }
+  }).join();
+}
+
+TEST(SharedRuntimeTest, OneClock) {
+  using namespace Shared;
+  auto& t = Trailokya::get_trailokya();
+  ns before = t.meter.raw_time();
+  // access times recorded by different threads are compared by the policy, so they read the same clock.
+  std::thread([&]() { t.meter.fast_forward(1h); }).join();
+  EXPECT_GE(t.meter.raw_time(), before + 1h);
+}
+
+TEST(SharedRuntimeTest, ConcurrentReadEvictRecompute) {
+  using namespace Shared;
+  constexpr size_t length = 128;
+  constexpr size_t thread_count = 8;
+  auto& t = Trailokya::get_trailokya();
+  std::vector<Zombie<int>> zs;
+  zs.push_back(Zombie<int>(0));
+  for (size_t i = 1; i < length; ++i) {
+    zs.push_back(bindZombie([&](int x) {
+      t.meter.fast_forward(1ms);
+      return Zombie<int>(x + 1);
+    }, zs.back()));
+  }
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back([&, i]() {
+      std::default_random_engine re(i);
+      std::uniform_int_distribution<size_t> dist(0, length - 1);
+      for (size_t j = 0; j < 2000; ++j) {
+        size_t idx = dist(re);
+        if (i % 2 == 0 && j % 16 == 0) {
+          zs[idx].evict();
+        } else if (i % 2 == 0 && j % 97 == 0 && !t.reaper.have_soul()) {
+          t.reaper.murder();
+        } else {
+          EXPECT_EQ(zs[idx].get_value(), static_cast<int>(idx));
+        }
+      }
+    });
+  }
+  for (std::thread& th : threads) {
+    th.join();
+  }
+  for (size_t i = 0; i < length; ++i) {
+    EXPECT_EQ(zs[i].get_value(), static_cast<int>(i));
+  }
+}
@@ -0,0 +1,146 @@
+#include "common.hpp"
+#include "zombie/zombie.hpp"
+
+#include <map>
+#include <thread>
+#include <sstream>
+#include <gtest/gtest.h>
+
+IMPORT_ZOMBIE(default_config)
+
+static_assert(trace_enabled(TraceLevel::Debug), "zombie_test is built with every trace point");
+
+std::map<TraceKind, size_t> CountEvents() {
+  std::map<TraceKind, size_t> ret;
+  Trace::drain([&](const TraceEvent& e) { ++ret[e.kind]; });
+  return ret;
+}
+
+TEST(TraceTest, RuntimeEvents) {
+  CountEvents();
+  Zombie<int> x(1);
+  Zombie<int> y = bindZombie([](int x) { return Zombie<int>(x + 1); }, x);
+  auto& t = Trailokya::get_trailokya();
+  t.reaper.murder();
+  EXPECT_TRUE(y.evicted());
+  EXPECT_EQ(y.get_value(), 2);
+
+  auto count = CountEvents();
+  EXPECT_EQ(count[TraceKind::InsertContext], 2);
+  EXPECT_EQ(count[TraceKind::Evict], 1);
+  EXPECT_EQ(count[TraceKind::ReplayBegin], 1);
+  EXPECT_EQ(count[TraceKind::ReplayEnd], 1);
+  EXPECT_EQ(count[TraceKind::CurrentTockChange], 1);
+  // drained events are gone.
+  EXPECT_TRUE(CountEvents().empty());
+}
+
+TEST(TraceTest, RingDropWhenFull) {
+  TraceRing ring;
+  for (size_t i = 0; i < TraceRing::capacity + 10; ++i) {
+    ring.push(TraceEvent{0, static_cast<int64_t>(i), 0, 0, TraceKind::Evict});
+  }
+  EXPECT_EQ(ring.dropped, 10);
+  int64_t expected = 0;
+  EXPECT_EQ(ring.drain([&](const TraceEvent& e) { EXPECT_EQ(e.a, expected++); }), TraceRing::capacity);
+  ring.push(TraceEvent{0, 42, 0, 0, TraceKind::Evict});
+  EXPECT_EQ(ring.drain([&](const TraceEvent& e) { EXPECT_EQ(e.a, 42); }), 1);
+}
+
+TEST(TraceTest, DrainOtherThreads) {
+  CountEvents();
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool emitted = false, drained = false;
+  std::thread th([&]() {
+    Trace::emit(TraceKind::CurrentTockChange, 7);
+    std::unique_lock<std::mutex> guard(mutex);
+    emitted = true;
+    cv.notify_all();
+    // the ring is unregistered when the thread exit, so stay alive until drained.
+    cv.wait(guard, [&]() { return drained; });
+  });
+  {
+    std::unique_lock<std::mutex> guard(mutex);
+    cv.wait(guard, [&]() { return emitted; });
+  }
+  std::stringstream ss;
+  EXPECT_EQ(Trace::dump(ss), 1);
+  EXPECT_EQ(ss.str().find("current_tock_change 7 0 0") != std::string::npos, true);
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    drained = true;
+    cv.notify_all();
+  }
+  th.join();
+}
+
+TEST(TraceTest, BinaryRoundTrip) {
+  std::vector<std::pair<uint16_t, TraceEvent>> events = {
+    {0, {1000, 5, 1, 2, TraceKind::InsertContext}},
+    {0, {1010, 7, -3, 4, TraceKind::Evict}},
+    {1, {500, 100, 0, 0, TraceKind::CurrentTockChange}},
+    {0, {1020, -9, 8, 7, TraceKind::HeapPop}},
+    {1, {400, 90, 65536, -65536, TraceKind::Resident}},
+    // does not fit in the 32 bits delta.
+    {0, {1020 + (int64_t(1) << 40), 3, 0, 1, TraceKind::ReplayBegin}},
+    {0, {1020 + (int64_t(1) << 40), 3, 0, 1, TraceKind::ReplayEnd}},
+    // a tock delta that does not fit in 32 bits, then one going back.
+    {0, {1030 + (int64_t(1) << 40), int64_t(1) << 33, 0, 1, TraceKind::ReplayBegin}},
+    {0, {1040 + (int64_t(1) << 40), 4, 0, 1, TraceKind::ReplayEnd}},
+    // an a that is not a tock, and does not fit in 32 bits either.
+    {0, {1050 + (int64_t(1) << 40), -(int64_t(1) << 40), 8, 7, TraceKind::HeapPop}},
+  };
+  std::stringstream ss;
+  {
+    TraceWriter w(ss);
+    for (const auto& [thread, e] : events) {
+      w.write(thread, e);
+    }
+  }
+  std::string bytes = ss.str();
+  // header, 10 records, a rebase for each thread plus one for the large gap, one for time going backward
+  // and two for the large tock deltas, and a wide record for the large a.
+  EXPECT_EQ(bytes.size(), 12 + (10 + 6 + 1) * TraceFormat::record_size);
+  EXPECT_EQ(bytes.substr(0, 4), "ZTRC");
+
+  TraceReader r(ss);
+  EXPECT_EQ(r.version, TraceFormat::version);
+  size_t i = 0;
+  r.for_each([&](uint16_t thread, const TraceEvent& e) {
+    ASSERT_LT(i, events.size());
+    const auto& [expected_thread, expected] = events[i++];
+    EXPECT_EQ(thread, expected_thread);
+    EXPECT_EQ(e.timestamp, expected.timestamp);
+    EXPECT_EQ(e.kind, expected.kind);
+    EXPECT_EQ(e.a, expected.a);
+    EXPECT_EQ(e.b, expected.b);
+    EXPECT_EQ(e.c, expected.c);
+  });
+  EXPECT_EQ(i, events.size());
+}
+
+TEST(TraceTest, BinaryRejectOtherFile) {
+  std::stringstream ss("{\"name\": \"evict\"}\n");
+  EXPECT_THROW(TraceReader r(ss), std::runtime_error);
+}
+
+TEST(TraceTest, WriterFlushRuntime) {
+  Trace::drain([](const TraceEvent&) { });
+  std::stringstream ss;
+  TraceWriter w(ss);
+  Zombie<int> x(1);
+  Zombie<int> y = bindZombie([](int x) { return Zombie<int>(x + 1); }, x);
+  // contexts left by other tests may go first.
+  while (!y.evicted()) {
+    Trailokya::get_trailokya().reaper.murder();
+  }
+  EXPECT_EQ(y.get_value(), 2);
+  size_t written = w.flush();
+  EXPECT_GT(written, 0);
+  std::map<TraceKind, size_t> count;
+  EXPECT_EQ(TraceReader(ss).for_each([&](uint16_t, const TraceEvent& e) { ++count[e.kind]; }), written);
+  EXPECT_GE(count[TraceKind::Evict], 1);
+  EXPECT_EQ(count[TraceKind::ReplayBegin], 1);
+  EXPECT_GT(count[TraceKind::Resident], 0);
+}
@@ -0,0 +1,220 @@
+// Summarize a binary zombie trace (see TraceWriter in include/zombie/trace.hpp) offline.
+//
+// usage: zombie_trace <trace file> [buckets] [top]
+// - buckets: number of time slices for the churn and memory tables, default 20
+// - top: number of contexts listed by recompute time, default 10
+#include "zombie/trace.hpp"
+
+#include <map>
+#include <cmath>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+struct Bucket {
+  size_t insert_contexts = 0;
+  size_t evictions = 0;
+  // evictions of a context which had been evicted before.
+  size_t reevictions = 0;
+  size_t replays = 0;
+  int64_t resident_last = 0;
+  int64_t resident_max = 0;
+  bool has_resident = false;
+};
+
+struct Recompute {
+  size_t count = 0;
+  int64_t total_ns = 0;
+  int64_t max_ns = 0;
+};
+
+struct Summary {
+  size_t events = 0;
+  int64_t begin = std::numeric_limits<int64_t>::max();
+  int64_t end = std::numeric_limits<int64_t>::min();
+  std::map<TraceKind, size_t> kinds;
+  std::map<uint16_t, size_t> threads;
+  std::map<int64_t, size_t> replay_depth;
+  // keyed by context start tock. replay time include nested replays.
+  std::map<int64_t, Recompute> recompute;
+  std::map<int64_t, size_t> evicted;
+  std::map<uint16_t, std::vector<std::pair<int64_t, int64_t>>> open_replays;
+  size_t unmatched_replays = 0;
+  std::vector<Bucket> buckets;
+};
+
+std::string human_bytes(int64_t bytes) {
+  const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+  double x = bytes;
+  size_t i = 0;
+  while (std::abs(x) >= 1024 && i + 1 < std::size(units)) {
+    x /= 1024;
+    ++i;
+  }
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(i == 0 ? 0 : 1) << x << units[i];
+  return ss.str();
+}
+
+std::string human_ns(int64_t ns) {
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(3);
+  if (ns >= 1000000000) {
+    ss << ns / 1e9 << "s";
+  } else if (ns >= 1000000) {
+    ss << ns / 1e6 << "ms";
+  } else if (ns >= 1000) {
+    ss << ns / 1e3 << "us";
+  } else {
+    ss << ns << "ns";
+  }
+  return ss.str();
+}
+
+std::string bar(size_t x, size_t max, size_t width = 40) {
+  return std::string(max == 0 ? 0 : (x * width + max - 1) / max, '#');
+}
+
+// the first pass find the time range, so the second pass can bucket.
+void scan_range(const std::string& path, Summary& s) {
+  std::ifstream is(path, std::ios::binary);
+  TraceReader(is).for_each([&](uint16_t, const TraceEvent& e) {
+    s.begin = std::min(s.begin, e.timestamp);
+    s.end = std::max(s.end, e.timestamp);
+  });
+}
+
+void summarize(const std::string& path, Summary& s) {
+  std::ifstream is(path, std::ios::binary);
+  int64_t span = std::max<int64_t>(s.end - s.begin + 1, 1);
+  auto bucket_of = [&](int64_t timestamp) -> Bucket& {
+    size_t i = static_cast<__int128>(timestamp - s.begin) * s.buckets.size() / span;
+    return s.buckets[i];
+  };
+  s.events = TraceReader(is).for_each([&](uint16_t thread, const TraceEvent& e) {
+    ++s.kinds[e.kind];
+    ++s.threads[thread];
+    Bucket& b = bucket_of(e.timestamp);
+    switch (e.kind) {
+    case TraceKind::InsertContext:
+      ++b.insert_contexts;
+      break;
+    case TraceKind::Evict:
+      ++b.evictions;
+      if (s.evicted[e.a]++ > 0) {
+        ++b.reevictions;
+      }
+      break;
+    case TraceKind::ReplayBegin:
+      ++b.replays;
+      ++s.replay_depth[e.c];
+      s.open_replays[thread].push_back({e.a, e.timestamp});
+      break;
+    case TraceKind::ReplayEnd: {
+      auto& open = s.open_replays[thread];
+      if (open.empty() || open.back().first != e.a) {
+        ++s.unmatched_replays;
+        break;
+      }
+      int64_t ns = e.timestamp - open.back().second;
+      open.pop_back();
+      Recompute& r = s.recompute[e.a];
+      ++r.count;
+      r.total_ns += ns;
+      r.max_ns = std::max(r.max_ns, ns);
+      break;
+    }
+    case TraceKind::Resident:
+      b.resident_last = e.b;
+      b.resident_max = b.has_resident ? std::max(b.resident_max, e.b) : e.b;
+      b.has_resident = true;
+      break;
+    default:
+      break;
+    }
+  });
+  for (const auto& [thread, open] : s.open_replays) {
+    s.unmatched_replays += open.size();
+  }
+}
+
+void print(const Summary& s, size_t top) {
+  std::cout << "events: " << s.events << ", threads: " << s.threads.size()
+            << ", duration: " << human_ns(s.events == 0 ? 0 : s.end - s.begin) << "\n";
+  for (const auto& [kind, count] : s.kinds) {
+    std::cout << "  " << std::left << std::setw(20) << trace_kind_name(kind) << std::right << count << "\n";
+  }
+
+  std::cout << "\nreplay depth histogram:\n";
+  size_t max_depth_count = 0;
+  for (const auto& [depth, count] : s.replay_depth) {
+    max_depth_count = std::max(max_depth_count, count);
+  }
+  for (const auto& [depth, count] : s.replay_depth) {
+    std::cout << std::setw(6) << depth << std::setw(12) << count << " " << bar(count, max_depth_count) << "\n";
+  }
+  if (s.unmatched_replays != 0) {
+    std::cout << "  (" << s.unmatched_replays << " replays without a matching begin/end)\n";
+  }
+
+  std::cout << "\nrecompute time per context (start tock, including nested replays):\n";
+  std::vector<std::pair<int64_t, Recompute>> contexts(s.recompute.begin(), s.recompute.end());
+  std::sort(contexts.begin(), contexts.end(), [](const auto& l, const auto& r) {
+    return l.second.total_ns > r.second.total_ns;
+  });
+  int64_t total = 0;
+  for (const auto& [tock, r] : contexts) {
+    total += r.total_ns;
+  }
+  std::cout << "  " << contexts.size() << " contexts replayed, summing to " << human_ns(total) << " (nested replays count toward each enclosing one)\n";
+  std::cout << std::setw(14) << "tock" << std::setw(10) << "replays" << std::setw(14) << "total" << std::setw(14) << "max" << "\n";
+  for (size_t i = 0; i < std::min(top, contexts.size()); ++i) {
+    const auto& [tock, r] = contexts[i];
+    std::cout << std::setw(14) << tock << std::setw(10) << r.count << std::setw(14) << human_ns(r.total_ns)
+              << std::setw(14) << human_ns(r.max_ns) << "\n";
+  }
+
+  size_t reevicted = 0;
+  for (const auto& [tock, count] : s.evicted) {
+    reevicted += count > 1;
+  }
+  std::cout << "\neviction churn: " << s.evicted.size() << " contexts evicted, " << reevicted
+            << " of them more than once\n";
+  std::cout << std::setw(14) << "time" << std::setw(10) << "inserts" << std::setw(10) << "evicts"
+            << std::setw(10) << "re-evicts" << std::setw(10) << "replays"
+            << std::setw(12) << "resident" << std::setw(12) << "max" << "\n";
+  int64_t span = s.end - s.begin;
+  for (size_t i = 0; i < s.buckets.size(); ++i) {
+    const Bucket& b = s.buckets[i];
+    std::cout << std::setw(14) << human_ns(static_cast<__int128>(span) * i / s.buckets.size())
+              << std::setw(10) << b.insert_contexts << std::setw(10) << b.evictions
+              << std::setw(10) << b.reevictions << std::setw(10) << b.replays;
+    if (b.has_resident) {
+      std::cout << std::setw(12) << human_bytes(b.resident_last) << std::setw(12) << human_bytes(b.resident_max);
+    }
+    std::cout << "\n";
+  }
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2 || argc > 4) {
+    std::cerr << "usage: " << argv[0] << " <trace file> [buckets] [top]" << std::endl;
+    return 1;
+  }
+  std::string path = argv[1];
+  size_t buckets = argc > 2 ? std::stoul(argv[2]) : 20;
+  size_t top = argc > 3 ? std::stoul(argv[3]) : 10;
+  try {
+    Summary s;
+    s.buckets.resize(std::max<size_t>(buckets, 1));
+    scan_range(path, s);
+    summarize(path, s);
+    print(s, top);
+  } catch (const std::exception& e) {
+    std::cerr << path << ": " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}